@@ -0,0 +1,410 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+/*
+ * cea_mt_bench.c - Multi-context concurrency benchmark for libcea
+ *
+ * This program:
+ *  1. Builds a synthetic H.264 Annex B stream carrying EIA-608 (CC1, CC3)
+ *     and CEA-708 (service 1) captions in GA94 SEI messages
+ *  2. Runs 1, 2, 4, ... N threads, each decoding the stream with its own
+ *     cea_ctx through cea_feed_packet() and a live caption callback
+ *  3. Reports aggregate packets/s and the scaling against one thread
+ *  4. Checks that every context produced the same captions as the
+ *     single-threaded run (any cross-context interference shows up here)
+ *
+ * Build with -DCEA_BUILD_BENCH=ON (add -DCEA_ENABLE_TSAN=ON to run the
+ * same workload under ThreadSanitizer).
+ * Usage: ./cea_mt_bench [max_threads] [packets_per_thread]
+ */
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cea.h"
+
+#define STREAM_FRAMES 900
+#define MAX_TRIPLETS  20
+
+/* ------------------------------------------------------------------ */
+/* Synthetic caption stream                                            */
+/* ------------------------------------------------------------------ */
+typedef struct {
+	unsigned char cc[MAX_TRIPLETS * 3];
+	int count;
+} frame_cc;
+
+static frame_cc frames[STREAM_FRAMES];
+static int cursor_608[2];
+static int cursor_708;
+static int seq_708;
+
+static unsigned char odd_parity(unsigned char b)
+{
+	int ones = 0;
+	b &= 0x7F;
+	for (int i = 0; i < 7; i++)
+		ones += (b >> i) & 1;
+	return (ones & 1) ? b : (unsigned char)(b | 0x80);
+}
+
+static void add_triplet(int f, unsigned char b0, unsigned char b1, unsigned char b2)
+{
+	frame_cc *fr = &frames[f % STREAM_FRAMES];
+	if (fr->count >= MAX_TRIPLETS)
+		return;
+	fr->cc[fr->count * 3]     = b0;
+	fr->cc[fr->count * 3 + 1] = b1;
+	fr->cc[fr->count * 3 + 2] = b2;
+	fr->count++;
+}
+
+/* One 608 byte pair per frame and field */
+static void put_608(int field, unsigned char c1, unsigned char c2)
+{
+	int f = cursor_608[field - 1]++;
+	add_triplet(f, field == 1 ? 0xFC : 0xFD, odd_parity(c1), odd_parity(c2));
+}
+
+/* Control codes are sent twice, as broadcasters do */
+static void cmd_608(int field, unsigned char c1, unsigned char c2)
+{
+	put_608(field, c1, c2);
+	put_608(field, c1, c2);
+}
+
+static void text_608(int field, const char *s)
+{
+	size_t len = strlen(s);
+	for (size_t i = 0; i < len; i += 2)
+		put_608(field, (unsigned char)s[i], i + 1 < len ? (unsigned char)s[i + 1] : 0);
+}
+
+/* Wrap a 708 service block in DTVCC packets, two byte pairs per frame */
+static void put_708(int service, const unsigned char *data, int len)
+{
+	while (len > 0) {
+		unsigned char pkt[128];
+		int chunk = len > 30 ? 30 : len;
+		int n = 0;
+
+		pkt[n++] = 0;
+		pkt[n++] = (unsigned char)((service << 5) | chunk);
+		memcpy(pkt + n, data, chunk);
+		n += chunk;
+		if (n & 1)
+			pkt[n++] = 0;
+		pkt[0] = (unsigned char)((seq_708 << 6) | (n / 2));
+		seq_708 = (seq_708 + 1) & 3;
+
+		for (int i = 0; i < n; i += 2) {
+			int f = cursor_708 + i / 4;
+			add_triplet(f, i == 0 ? 0xFF : 0xFE, pkt[i], pkt[i + 1]);
+		}
+		cursor_708 += (n + 3) / 4;
+		data += chunk;
+		len -= chunk;
+	}
+}
+
+static void build_stream(void)
+{
+	static const char *lines[] = {
+		"The quick brown fox", "jumps over the lazy dog",
+		"Closed captions", "on many channels at once",
+	};
+
+	memset(frames, 0, sizeof(frames));
+
+	/* CC1: pop-on captions */
+	for (int i = 0; cursor_608[0] < STREAM_FRAMES - 60; i++) {
+		cmd_608(1, 0x14, 0x20);         /* RCL */
+		cmd_608(1, 0x14, 0x70);         /* PAC row 15 */
+		text_608(1, lines[i % 4]);
+		cmd_608(1, 0x14, 0x2F);         /* EOC */
+		cursor_608[0] += 30;
+	}
+
+	/* CC3: roll-up captions */
+	cmd_608(2, 0x15, 0x25);                 /* RU2 */
+	for (int i = 0; cursor_608[1] < STREAM_FRAMES - 60; i++) {
+		cmd_608(2, 0x15, 0x2D);         /* CR */
+		text_608(2, lines[(i + 1) % 4]);
+		cursor_608[1] += 10;
+	}
+
+	/* 708 service 1: define a visible window, write, clear */
+	for (int i = 0; cursor_708 < STREAM_FRAMES - 60; i++) {
+		unsigned char d[96];
+		int n = 0;
+		const char *s = lines[(i + 2) % 4];
+
+		d[n++] = 0x98; d[n++] = 0x20; d[n++] = 70; d[n++] = 0;  /* DF0, visible */
+		d[n++] = 0x60; d[n++] = 41;   d[n++] = 0x21;
+		memcpy(d + n, s, strlen(s));
+		n += (int)strlen(s);
+		d[n++] = 0x0D;                                           /* CR */
+		memcpy(d + n, s, strlen(s));
+		n += (int)strlen(s);
+		put_708(1, d, n);
+		cursor_708 += 40;
+
+		d[0] = 0x88; d[1] = 0x01;                                /* CLW */
+		put_708(1, d, 2);
+		cursor_708 += 20;
+	}
+
+	/* Pad every frame like a real encoder does */
+	for (int f = 0; f < STREAM_FRAMES; f++)
+		while (frames[f].count < 10)
+			add_triplet(f, 0xFA, 0x00, 0x00);
+}
+
+/* ------------------------------------------------------------------ */
+/* H.264 packetizer                                                    */
+/* ------------------------------------------------------------------ */
+typedef struct {
+	unsigned char *data;
+	int size;
+	int64_t pts_ms;
+} packet;
+
+static packet *packets;
+
+/* Append a NAL with emulation prevention bytes */
+static int put_nal(unsigned char *out, const unsigned char *nal, int len)
+{
+	int n = 0, zeros = 0;
+
+	out[n++] = 0; out[n++] = 0; out[n++] = 0; out[n++] = 1;
+	for (int i = 0; i < len; i++) {
+		if (zeros >= 2 && nal[i] <= 3) {
+			out[n++] = 3;
+			zeros = 0;
+		}
+		out[n++] = nal[i];
+		zeros = nal[i] == 0 ? zeros + 1 : 0;
+	}
+	return n;
+}
+
+static void build_packets(void)
+{
+	unsigned int rng = 1;
+
+	packets = calloc(STREAM_FRAMES, sizeof(packet));
+	if (!packets) {
+		fprintf(stderr, "Error: out of memory\n");
+		exit(1);
+	}
+
+	for (int f = 0; f < STREAM_FRAMES; f++) {
+		unsigned char sei[MAX_TRIPLETS * 3 + 32];
+		unsigned char slice[1024];
+		unsigned char *out = malloc(4096);
+		const frame_cc *fr = &frames[f];
+		int n = 0, s = 0;
+
+		if (!out) {
+			fprintf(stderr, "Error: out of memory\n");
+			exit(1);
+		}
+
+		/* Access unit delimiter */
+		static const unsigned char aud[] = {0x09, 0xF0};
+		n += put_nal(out + n, aud, sizeof(aud));
+
+		/* SEI: user_data_registered_itu_t_t35 carrying GA94 cc_data */
+		sei[s++] = 0x06;
+		sei[s++] = 4;
+		sei[s++] = (unsigned char)(10 + fr->count * 3 + 1);
+		sei[s++] = 0xB5; sei[s++] = 0x00; sei[s++] = 0x31;
+		sei[s++] = 'G';  sei[s++] = 'A';  sei[s++] = '9'; sei[s++] = '4';
+		sei[s++] = 0x03;
+		sei[s++] = (unsigned char)(0x40 | fr->count);
+		sei[s++] = 0xFF;
+		memcpy(sei + s, fr->cc, fr->count * 3);
+		s += fr->count * 3;
+		sei[s++] = 0xFF;
+		sei[s++] = 0x80;
+		n += put_nal(out + n, sei, s);
+
+		/* Pseudo-random slice payload so the demuxer scans real bytes */
+		slice[0] = f == 0 ? 0x65 : 0x01;
+		for (int i = 1; i < (int)sizeof(slice); i++) {
+			rng = rng * 1103515245 + 12345;
+			slice[i] = (unsigned char)(rng >> 16);
+		}
+		n += put_nal(out + n, slice, sizeof(slice));
+
+		packets[f].data = out;
+		packets[f].size = n;
+		packets[f].pts_ms = 1000 + (int64_t)f * 1001 / 30;
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* Worker                                                              */
+/* ------------------------------------------------------------------ */
+typedef struct {
+	pthread_t thread;
+	long packets;      /* packets to feed */
+	long shows;        /* SHOW events received */
+	long clears;       /* CLEAR events received */
+	uint32_t checksum; /* over caption text and timestamps */
+	int failed;
+} worker;
+
+static void on_caption(const cea_caption *cap, void *userdata)
+{
+	worker *w = (worker *)userdata;
+	uint32_t h = w->checksum * 31 + (uint32_t)cap->pts_ms;
+
+	if (cap->text) {
+		w->shows++;
+		for (const char *p = cap->text; *p; p++)
+			h = h * 31 + (unsigned char)*p;
+	} else {
+		w->clears++;
+	}
+	w->checksum = h;
+}
+
+static void *worker_main(void *arg)
+{
+	worker *w = (worker *)arg;
+	cea_ctx *ctx = cea_init_default();
+
+	if (!ctx || cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_ANNEX_B, NULL, 0) < 0) {
+		w->failed = 1;
+		cea_free(ctx);
+		return NULL;
+	}
+	cea_set_caption_callback(ctx, on_caption, w);
+
+	/* Loop over the stream, keeping PTS monotonic across repetitions */
+	for (long i = 0; i < w->packets; i++) {
+		const packet *p = &packets[i % STREAM_FRAMES];
+		int64_t loop_ms = (i / STREAM_FRAMES) * (int64_t)STREAM_FRAMES * 1001 / 30;
+		if (cea_feed_packet(ctx, p->data, p->size, p->pts_ms + loop_ms) < 0)
+			w->failed = 1;
+	}
+	cea_flush(ctx);
+	cea_free(ctx);
+	return NULL;
+}
+
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Run n contexts on n threads; returns aggregate packets/s or -1 on error */
+static double run(int n, long packets_per_thread, const worker *reference)
+{
+	worker *w = calloc(n, sizeof(worker));
+	int ok = 1;
+
+	if (!w)
+		return -1;
+
+	double t0 = now_sec();
+	for (int i = 0; i < n; i++) {
+		w[i].packets = packets_per_thread;
+		if (pthread_create(&w[i].thread, NULL, worker_main, &w[i]) != 0) {
+			fprintf(stderr, "Error: cannot create thread %d\n", i);
+			n = i;
+			ok = 0;
+			break;
+		}
+	}
+	for (int i = 0; i < n; i++)
+		pthread_join(w[i].thread, NULL);
+	double elapsed = now_sec() - t0;
+
+	for (int i = 0; i < n; i++) {
+		if (w[i].failed) {
+			fprintf(stderr, "Error: context %d failed\n", i);
+			ok = 0;
+		} else if (w[i].shows != reference->shows ||
+		           w[i].clears != reference->clears ||
+		           w[i].checksum != reference->checksum) {
+			fprintf(stderr, "Error: context %d output differs from the reference run\n", i);
+			ok = 0;
+		}
+	}
+	free(w);
+
+	if (!ok)
+		return -1;
+	return elapsed > 0 ? (double)n * packets_per_thread / elapsed : 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Main                                                                 */
+/* ------------------------------------------------------------------ */
+int main(int argc, char *argv[])
+{
+	int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+	long packets_per_thread = argc > 2 ? atol(argv[2]) : 20000;
+
+	if (max_threads < 1 || packets_per_thread < 1) {
+		fprintf(stderr, "Usage: %s [max_threads] [packets_per_thread]\n", argv[0]);
+		return 1;
+	}
+
+	build_stream();
+	build_packets();
+
+	printf("libcea %s multi-context benchmark\n", cea_version());
+	printf("%ld packets per context, synthetic H.264 with CC1/CC3/708 service 1\n\n",
+	       packets_per_thread);
+
+	/* Single-thread run doubles as the reference output */
+	worker reference;
+	memset(&reference, 0, sizeof(reference));
+	reference.packets = packets_per_thread;
+	worker_main(&reference);
+	if (reference.failed) {
+		fprintf(stderr, "Error: reference run failed\n");
+		return 1;
+	}
+	printf("Captions per context: %ld shown, %ld cleared (checksum %08x)\n\n",
+	       reference.shows, reference.clears, (unsigned)reference.checksum);
+
+	printf("%8s %14s %10s\n", "threads", "packets/s", "scaling");
+	double base = 0;
+	int status = 0;
+	for (int n = 1;; n = n * 2 > max_threads ? max_threads : n * 2) {
+		double rate = run(n, packets_per_thread, &reference);
+		if (rate < 0) {
+			status = 1;
+			break;
+		}
+		if (n == 1)
+			base = rate;
+		printf("%8d %14.0f %9.2fx\n", n, rate, base > 0 ? rate / base : 0);
+		fflush(stdout);
+		if (n == max_threads)
+			break;
+	}
+
+	for (int f = 0; f < STREAM_FRAMES; f++)
+		free(packets[f].data);
+	free(packets);
+
+	return status;
+}
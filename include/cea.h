@@ -9,6 +9,7 @@
 #ifndef CEA_H
 #define CEA_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "cea_version.h"
 
@@ -31,7 +32,14 @@ typedef enum {
 /* Log callback: receives level, formatted message, and user-supplied pointer */
 typedef void (*cea_log_callback)(cea_log_level level, const char *msg, void *userdata);
 
-/* Opaque context */
+/*
+ * Opaque context.
+ *
+ * Thread safety: contexts share no writable state, so independent contexts
+ * may be created, fed and freed concurrently from different threads. A
+ * single context is not synchronised and must only be used by one thread
+ * at a time. Callbacks run on the thread that feeds the context.
+ */
 typedef struct cea_ctx cea_ctx;
 
 /*
@@ -106,6 +114,16 @@ typedef struct {
 	char info[4];       /* Decoder info: "608" or "708" */
 } cea_caption;
 
+/* EIA-608 channels, for cea_options.disable_608 */
+typedef enum {
+	CEA_608_CC1     = 1 << 0,
+	CEA_608_CC2     = 1 << 1,
+	CEA_608_CC3     = 1 << 2,
+	CEA_608_CC4     = 1 << 3,
+	CEA_608_FIELD_1 = CEA_608_CC1 | CEA_608_CC2,
+	CEA_608_FIELD_2 = CEA_608_CC3 | CEA_608_CC4,
+} cea_608_channel_mask;
+
 /* Options for initialization */
 typedef struct {
 	int enable_708;         /* Enable CEA-708 decoding (default: 1) */
@@ -116,6 +134,20 @@ typedef struct {
 	                         * The library tries SPS max_num_reorder_frames first,
 	                         * then falls back to an SPS-based heuristic, then to
 	                         * this value (default 4 if left at 0). */
+	int full_packet_scan;   /* cea_feed_packet(): 0 = stop scanning at the first
+	                         * coded slice, since H.264/HEVC SEI/SPS and MPEG-2 picture
+	                         * user data must precede it (default).
+	                         * 1 = walk the whole packet, for streams that place
+	                         * caption data after the slices. */
+	int adaptive_reorder;   /* cea_feed_packet() without a DTS: 0 = off (default).
+	                         * 1 = unless the SPS signals max_num_reorder_frames,
+	                         * size the window from the deepest PTS inversion seen
+	                         * over the last 64 packets instead of a guess, so
+	                         * streams without B-frames get no reorder delay. */
+	int disable_608;        /* Bitwise OR of cea_608_channel_mask values for
+	                         * EIA-608 channels not to decode (default 0: CC1-CC4).
+	                         * Disabling a whole field skips its byte pairs
+	                         * entirely. */
 } cea_options;
 
 /* Initialize with default options */
@@ -143,17 +175,20 @@ int cea_flush(cea_ctx *ctx);
 typedef enum {
 	CEA_CODEC_MPEG2,
 	CEA_CODEC_H264,
+	CEA_CODEC_HEVC,
+	CEA_CODEC_AV1,    /* Packets are OBU streams with size fields; packaging is ignored */
 } cea_codec_type;
 
 /* Packaging formats for compressed video */
 typedef enum {
 	CEA_PACKAGING_ANNEX_B,  /* Start-code delimited (MPEG-2 always uses this) */
-	CEA_PACKAGING_AVCC,     /* Length-prefixed NAL units (H.264 in MP4/MKV) */
+	CEA_PACKAGING_AVCC,     /* Length-prefixed NAL units (H.264/HEVC in MP4/MKV) */
 } cea_packaging_type;
 
 /*
  * Configure the demuxer. Must be called before cea_feed_packet().
- * extradata/extradata_size: optional codec extradata (SPS/PPS for H.264).
+ * extradata/extradata_size: optional codec extradata (avcC for H.264,
+ *   hvcC for HEVC, or Annex B parameter sets).
  *   Pass NULL/0 if not available — the library will try to parse it
  *   from the stream, falling back to a default reorder window of 4.
  * Returns 0 on success, negative on error (e.g. MPEG-2 + AVCC).
@@ -171,16 +206,65 @@ int cea_set_demuxer(cea_ctx *ctx, cea_codec_type codec,
 int cea_feed_packet(cea_ctx *ctx, const unsigned char *pkt_data,
                          int pkt_size, int64_t pts_ms);
 
+/* Flags for cea_feed_packet_ex() */
+typedef enum {
+	CEA_PACKET_DTS_VALID     = 1 << 0,  /* dts_ms is set */
+	CEA_PACKET_DISCONTINUITY = 1 << 1,  /* timestamps jump at this packet */
+} cea_packet_flags;
+
+/*
+ * Like cea_feed_packet, with the container's decode timestamp.
+ * With CEA_PACKET_DTS_VALID, buffered captions are released as soon as
+ * their PTS is <= dts_ms of the incoming packet (no later packet can
+ * precede them), instead of after a fixed reorder window. DTS must
+ * increase from packet to packet; if it stalls, no more than 16 captions
+ * are held back.
+ * CEA_PACKET_DISCONTINUITY releases everything buffered before this
+ * packet is processed (e.g. after a seek or splice).
+ * flags: bitwise OR of cea_packet_flags.
+ * Returns 0 on success, negative on error.
+ */
+int cea_feed_packet_ex(cea_ctx *ctx, const unsigned char *pkt_data,
+                       int pkt_size, int64_t pts_ms, int64_t dts_ms, int flags);
+
+/*
+ * Demux only: find the cc_data in a compressed packet without decoding it,
+ * e.g. to carry captions through a transcoder. Requires cea_set_demuxer().
+ * Nothing is buffered or reordered: the result belongs to this packet, so
+ * attach it to the frame decoded from it.
+ * cc_data: set to cc_count 3-byte triplets (cc_valid|cc_type, byte1, byte2)
+ *   in a buffer owned by ctx, valid until the next call on ctx.
+ * cc_count: set to the number of triplets, 0 if the packet has none.
+ * Returns 0 on success, negative on error.
+ */
+int cea_extract_cc_data(cea_ctx *ctx, const unsigned char *pkt_data, int pkt_size,
+                        const unsigned char **cc_data, int *cc_count);
+
 /*
  * Retrieve decoded captions. Call after feed/flush.
  * out: array to fill with caption entries
  * max_captions: size of out array
+ * Captions come 608 first, then 708, each in the order they completed.
  * Returns number of captions written to out (0 if none available).
  * Caller must NOT free the text pointers -- they are valid until the
  * next call to cea_feed, cea_flush, or cea_free.
  */
 int cea_get_captions(cea_ctx *ctx, cea_caption *out, int max_captions);
 
+/*
+ * Allocation-free variant of cea_get_captions. Caption text is rendered
+ * straight into the caller's arena (each string NUL-terminated), so the
+ * text pointers in out stay valid for as long as the arena does.
+ * Captions come in the same order as from cea_get_captions(): all 608
+ * captions, then all 708 captions. If out or the arena fills up, the
+ * remaining captions stay pending for the next call.
+ * arena_used: optional, receives the number of arena bytes written.
+ * Returns number of captions written to out, or -1 on invalid arguments
+ * or if captions are pending but the next one does not fit in arena_len.
+ */
+int cea_get_captions_into(cea_ctx *ctx, cea_caption *out, int max_captions,
+                          char *arena, size_t arena_len, size_t *arena_used);
+
 /*
  * Caption callback for live/streaming mode.
  *
@@ -203,9 +287,12 @@ int cea_get_captions(cea_ctx *ctx, cea_caption *out, int max_captions);
  * as soon as text appears on the virtual screen; the "clear" event fires
  * when the screen is replaced or erased.
  *
- * For CEA-708 both events arrive together (back-to-back) when the
- * caption segment is complete, because the 708 decoder does not expose
- * an intermediate screen-state view.
+ * For CEA-708 the "show" event fires when a window is displayed or the
+ * text of a visible window changes (characters, carriage returns), with
+ * the text of all visible windows of the service. The "clear" event fires
+ * when the caption segment completes or its text goes off screen. A
+ * segment that appears and ends within a single feed gets both events
+ * back-to-back.
  */
 typedef void (*cea_caption_callback)(const cea_caption *cap, void *userdata);
 
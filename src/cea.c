@@ -15,6 +15,7 @@
 #include "cea_decoders_608.h"
 #include "cea_decoders_708.h"
 #include "cea_demux.h"
+#include "cea_caption_ring.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -58,26 +59,48 @@ static const char *color_608_hex(enum cea_decoder_608_color_code c)
 	}
 }
 
+/* Bounded output buffer for the text renderers */
+struct text_out
+{
+	char *buf;
+	size_t cap; /* including room for the terminating NUL */
+	size_t len;
+};
+
+/* Append n bytes, or return -1 (appending nothing) if they don't fit */
+static int text_put(struct text_out *out, const char *s, size_t n)
+{
+	if (n >= out->cap - out->len)
+		return -1;
+	memcpy(out->buf + out->len, s, n);
+	out->len += n;
+	return 0;
+}
+
+#define TEXT_PUT(out, s, n)                  \
+	do                                   \
+	{                                    \
+		if (text_put(out, s, n) < 0) \
+			return -1;           \
+	} while (0)
+
 /*
- * Build SRT-styled UTF-8 text from a 608 screen.
+ * Render SRT-styled UTF-8 text from a 608 screen into out (NUL-terminated).
  * Emits <i>, <u>, <font color="..."> tags around styled runs.
- * Returns malloc'd string (caller must free), or NULL if screen is empty.
+ * Returns 0 on success, -1 if the text does not fit.
  * Sets *out_bottom_row to the last row index with content (-1 if none).
  */
-static char *screen_608_to_styled_text(struct eia608_screen *screen, int *out_bottom_row)
+static int render_608_text(struct eia608_screen *screen, struct text_out *out, int *out_bottom_row)
 {
-	/* Worst case: 15 rows, 32 chars each expanding to ~60 bytes with tags */
-	size_t cap = 15 * 32 * 60 + 256;
-	char *buf = (char *)malloc(cap);
-	if (!buf)
-		return NULL;
-	size_t len = 0;
 	int rows_written = 0;
 	int bottom_row = -1;
 
+	if (out->cap == 0)
+		return -1;
+
 	for (int r = 0; r < 15; r++)
 	{
-		if (!screen->row_used[r])
+		if (!(screen->row_used & CEA_608_ROW_BIT(r)))
 			continue;
 		bottom_row = r;
 
@@ -89,7 +112,7 @@ static char *screen_608_to_styled_text(struct eia608_screen *screen, int *out_bo
 			continue;
 
 		if (rows_written > 0)
-			buf[len++] = '\n';
+			TEXT_PUT(out, "\n", 1);
 
 		/* Track current style state */
 		const char *cur_color = NULL; /* NULL = no <font> tag open */
@@ -98,8 +121,8 @@ static char *screen_608_to_styled_text(struct eia608_screen *screen, int *out_bo
 
 		for (int c = 0; c <= last; c++)
 		{
-			enum cea_decoder_608_color_code col = screen->colors[r][c];
-			enum font_bits font = screen->fonts[r][c];
+			enum cea_decoder_608_color_code col = CEA_608_STYLE_COLOR(screen->styles[r][c]);
+			enum font_bits font = CEA_608_STYLE_FONT(screen->styles[r][c]);
 			const char *hex = color_608_hex(col);
 			int want_italic = (font == FONT_ITALICS || font == FONT_UNDERLINED_ITALICS);
 			int want_underline = (font == FONT_UNDERLINED || font == FONT_UNDERLINED_ITALICS);
@@ -107,75 +130,104 @@ static char *screen_608_to_styled_text(struct eia608_screen *screen, int *out_bo
 			/* Close tags if style changed (reverse order) */
 			if (cur_underline && !want_underline)
 			{
-				memcpy(buf + len, "</u>", 4); len += 4;
+				TEXT_PUT(out, "</u>", 4);
 				cur_underline = 0;
 			}
 			if (cur_italic && !want_italic)
 			{
-				memcpy(buf + len, "</i>", 4); len += 4;
+				TEXT_PUT(out, "</i>", 4);
 				cur_italic = 0;
 			}
 			if (cur_color && cur_color != hex)
 			{
-				memcpy(buf + len, "</font>", 7); len += 7;
+				TEXT_PUT(out, "</font>", 7);
 				cur_color = NULL;
 			}
 
 			/* Open tags if needed */
 			if (hex && cur_color != hex)
 			{
-				len += sprintf(buf + len, "<font color=\"%s\">", hex);
+				char tag[32];
+				int n = snprintf(tag, sizeof(tag), "<font color=\"%s\">", hex);
+				TEXT_PUT(out, tag, n);
 				cur_color = hex;
 			}
 			if (want_italic && !cur_italic)
 			{
-				memcpy(buf + len, "<i>", 3); len += 3;
+				TEXT_PUT(out, "<i>", 3);
 				cur_italic = 1;
 			}
 			if (want_underline && !cur_underline)
 			{
-				memcpy(buf + len, "<u>", 3); len += 3;
+				TEXT_PUT(out, "<u>", 3);
 				cur_underline = 1;
 			}
 
 			/* Write the character as UTF-8 */
-			int bytes = get_char_in_utf_8((unsigned char *)buf + len, screen->characters[r][c]);
-			len += bytes;
+			unsigned char utf8[4];
+			int bytes = get_char_in_utf_8(utf8, screen->characters[r][c]);
+			TEXT_PUT(out, (const char *)utf8, bytes);
 		}
 
 		/* Close any remaining open tags at end of row */
 		if (cur_underline)
-		{ memcpy(buf + len, "</u>", 4); len += 4; }
+			TEXT_PUT(out, "</u>", 4);
 		if (cur_italic)
-		{ memcpy(buf + len, "</i>", 4); len += 4; }
+			TEXT_PUT(out, "</i>", 4);
 		if (cur_color)
-		{ memcpy(buf + len, "</font>", 7); len += 7; }
+			TEXT_PUT(out, "</font>", 7);
 
 		rows_written++;
 	}
 
-	buf[len] = '\0';
+	out->buf[out->len] = '\0';
 	if (out_bottom_row)
 		*out_bottom_row = bottom_row;
+	return 0;
+}
 
-	if (len == 0)
+/*
+ * Build SRT-styled UTF-8 text from a 608 screen.
+ * Returns malloc'd string (caller must free), or NULL if screen is empty.
+ * Sets *out_bottom_row to the last row index with content (-1 if none).
+ */
+static char *screen_608_to_styled_text(struct eia608_screen *screen, int *out_bottom_row)
+{
+	/* Worst case: 15 rows, 32 chars each expanding to ~60 bytes with tags */
+	struct text_out out;
+	out.cap = 15 * 32 * 60 + 256;
+	out.len = 0;
+	out.buf = (char *)malloc(out.cap);
+	if (!out.buf)
+		return NULL;
+
+	if (render_608_text(screen, &out, out_bottom_row) < 0 || out.len == 0)
 	{
-		free(buf);
+		free(out.buf);
 		return NULL;
 	}
-	return buf;
+	return out.buf;
 }
 
+/* Packets of PTS history the adaptive reorder window is learned from */
+#define CEA_REORDER_HISTORY 64
+
+/* Entries the DTS path holds at most. No conforming stream keeps more
+ * pictures waiting for output than the largest DPB (16 frames), so past
+ * that the DTS is stuck or bogus and entries go out in PTS order. */
+#define CEA_REORDER_DTS_CAP 16
+
 /* Internal context */
 struct cea_ctx
 {
 	struct lib_cc_decode *dec;
 	struct cea_common_timing_ctx *timing;
-	struct cc_subtitle sub;     /* 608 subtitle output */
-	struct cc_subtitle sub_708; /* 708 subtitle output (separate to avoid corruption) */
+	struct cc_caption_ring ring; /* 608 and 708 caption output */
 	/* Heap-allocated report structs (decoder stores pointers to these) */
 	struct cea_decoder_608_report *report_608;
 	struct cea_decoder_dtvcc_report *report_708;
+	/* 608 decoder settings (the 608 contexts keep a pointer to this) */
+	struct cea_decoder_608_settings settings_608;
 	/* Storage for extracted captions */
 	cea_caption *captions;
 	int caption_count;
@@ -189,32 +241,52 @@ struct cea_ctx
 	cea_packaging_type packaging;
 	int nal_length_size;           /* AVCC only: 0 = not yet detected, then 1-4 */
 	int max_reorder_frames;        /* From SPS: -1=unknown, 0+=parsed */
+	int reorder_exact;             /* max_reorder_frames is signalled, not guessed */
+	cea_sps_cache sps_cache;       /* In-band SPS units already parsed */
 	int reorder_window_override;   /* From user options: 0=auto, >0=override */
-	/* Reorder buffer for B-frame PTS sorting */
+	int full_packet_scan;          /* From user options: don't stop at the first slice */
+	int adaptive_reorder;          /* From user options: learn the window from PTS */
+	/* PTS inversion history for adaptive_reorder: for each of the last
+	 * CEA_REORDER_HISTORY packets, its PTS and how many packets before it
+	 * in the history had a later PTS (the depth the buffer had to cover) */
+	int64_t reorder_hist_pts[CEA_REORDER_HISTORY];
+	unsigned char reorder_hist_depth[CEA_REORDER_HISTORY];
+	int reorder_hist_count;
+	int reorder_hist_pos;
+	/* Reorder buffer for B-frame PTS sorting: entries stay in their slot,
+	 * reorder_heap is a min-heap of slot indices ordered by (pts, seq) */
 	struct cc_reorder_entry {
 		int64_t pts_ms;
+		uint64_t seq;            /* arrival order, breaks PTS ties */
 		int cc_count;
 		unsigned char cc_data[31 * 3];
 	} *reorder_buf;
-	int reorder_count;
-	int reorder_cap;
+	int *reorder_heap;
+	int *reorder_free;           /* stack of unused slots */
+	int reorder_count;           /* entries in the heap */
+	int reorder_free_count;
+	int reorder_cap;             /* slots allocated */
+	uint64_t reorder_seq;
+	/* cc_data returned by cea_extract_cc_data() */
+	unsigned char extract_buf[31 * 3];
 	/* Live / streaming callback (optional) */
 	cea_caption_callback live_cb;
 	void *live_cb_userdata;
 	/* last current_visible_start_ms we reported per CC channel
 	 * index 0=CC1, 1=CC2, 2=CC3, 3=CC4 */
 	int64_t live_screen_start_ms[4];
+	/* last visible_change_seq we looked at per 708 service, and whether a
+	 * "show" event is out for the caption that service is building */
+	unsigned int live_708_seq[CEA_DTVCC_MAX_SERVICES];
+	unsigned char live_708_shown[CEA_DTVCC_MAX_SERVICES];
 	/* Absolute PTS calibration for live callbacks.
 	 * pts_abs_offset_ms = pts_ms_fed - fts_now (constant once timing is stable).
 	 * Used to convert library-internal fts_now-relative times to absolute PTS. */
 	int64_t pts_abs_offset_ms;
 	int     pts_abs_calibrated;
 	int64_t last_feed_pts_ms;    /* pts_ms from the most recent cea_feed() call */
-	/* Logger */
-	cea_log_callback log_cb;
-	void            *log_ud;
-	cea_log_level    log_min_level;
-	int64_t          log_debug_mask;
+	/* Logger, shared by pointer with the decoders of this context */
+	struct cea_logger log;
 };
 
 /* Free previously stored captions text */
@@ -228,29 +300,48 @@ static void clear_caption_storage(cea_ctx *ctx)
 	ctx->caption_count = 0;
 }
 
-/* Count captions in a subtitle chain */
-static int count_sub_chain(struct cc_subtitle *head)
+/* Fill a caption from a 608 screen and its rendered text */
+static void fill_608_caption(cea_caption *cap, struct eia608_screen *screen, char *text, int bottom_row)
 {
-	int count = 0;
-	for (struct cc_subtitle *s = head; s; s = s->next)
+	memset(cap, 0, sizeof(*cap));
+	cap->text = text;
+	cap->start_ms = screen->start_time;
+	cap->end_ms = screen->end_time;
+	cap->field = screen->my_field;
+	cap->channel = screen->my_channel;
+	cap->base_row = bottom_row;
+	cap->mode = cc_mode_to_cea(screen->mode);
+	strncpy(cap->info, "608", 3);
+	cap->info[3] = '\0';
+}
+
+/* Fill a caption from a 708 text event, text being the caller's copy of ev->text */
+static void fill_708_caption(cea_caption *cap, struct cc_caption_event *ev, char *text)
+{
+	memset(cap, 0, sizeof(*cap));
+	cap->text = text;
+	cap->start_ms = ev->start_time;
+	cap->end_ms = ev->end_time;
+	/* info is "7XX" where XX is the service number (01-63) */
+	if (ev->info[0] == '7')
 	{
-		if (s->got_output && s->nb_data > 0)
-		{
-			if (s->type == CC_608)
-				count += (int)s->nb_data;
-			else
-				count++;
-		}
+		cap->field = 3;
+		cap->channel = atoi(ev->info + 1);
 	}
-	return count;
+	else
+		cap->field = 1;
+	cap->base_row = ev->flags; /* set by 708 output */
+	cap->mode = ev->mode;
+	strncpy(cap->info, "708", 3);
+	cap->info[3] = '\0';
 }
 
-/* Walk the cc_subtitle linked list and extract captions */
+/* Convert the pending caption ring events into ctx->captions */
 static void collect_captions(cea_ctx *ctx)
 {
 	clear_caption_storage(ctx);
 
-	int count = count_sub_chain(&ctx->sub) + count_sub_chain(&ctx->sub_708);
+	int count = (int)ctx->ring.count;
 
 	if (count == 0)
 		return;
@@ -260,58 +351,30 @@ static void collect_captions(cea_ctx *ctx)
 	if (!ctx->captions || !ctx->text_storage)
 		return;
 
-	/* Extract from both chains: 608 first, then 708 */
+	/* 608 captions first, then 708 */
 	int idx = 0;
-	struct cc_subtitle *chains[2] = { &ctx->sub, &ctx->sub_708 };
-	for (int chain = 0; chain < 2; chain++)
+	for (int pass = 0; pass < 2; pass++)
 	{
-		for (struct cc_subtitle *s = chains[chain]; s && idx < count; s = s->next)
+		for (unsigned int i = 0; i < ctx->ring.count && idx < count; i++)
 		{
-			if (!s->got_output || s->nb_data == 0)
+			struct cc_caption_event *ev = cc_ring_at(&ctx->ring, i);
+			if (ev->collected)
 				continue;
 
-			if (s->type == CC_TEXT && s->data)
+			if (pass == 0 && ev->type == CC_608)
 			{
-				ctx->text_storage[idx] = strdup((char *)s->data);
-				ctx->captions[idx].text = ctx->text_storage[idx];
-				ctx->captions[idx].start_ms = s->start_time;
-				ctx->captions[idx].end_ms = s->end_time;
-				/* info is "7XX" where XX is the service number (01-63) */
-				if (s->info[0] == '7')
-				{
-					ctx->captions[idx].field = 3;
-					ctx->captions[idx].channel = atoi(s->info + 1);
-				}
-				else
-					ctx->captions[idx].field = 1;
-				ctx->captions[idx].base_row = s->flags; /* set by 708 output */
-				ctx->captions[idx].mode = s->mode;
-				strncpy(ctx->captions[idx].info, "708", 3);
-				ctx->captions[idx].info[3] = '\0';
-				idx++;
+				int bottom_row = -1;
+				char *text = screen_608_to_styled_text(&ev->screen, &bottom_row);
+				if (!text)
+					continue;
+				ctx->text_storage[idx] = text;
+				fill_608_caption(&ctx->captions[idx++], &ev->screen, text, bottom_row);
 			}
-			else if (s->type == CC_608 && s->data)
+			else if (pass == 1 && ev->type == CC_TEXT)
 			{
-				struct eia608_screen *screens = (struct eia608_screen *)s->data;
-				for (unsigned int si = 0; si < s->nb_data && idx < count; si++)
-				{
-					struct eia608_screen *screen = &screens[si];
-					int bottom_row = -1;
-					char *text = screen_608_to_styled_text(screen, &bottom_row);
-					if (!text)
-						continue;
-					ctx->text_storage[idx] = text;
-					ctx->captions[idx].text = text;
-					ctx->captions[idx].start_ms = screen->start_time;
-					ctx->captions[idx].end_ms = screen->end_time;
-					ctx->captions[idx].field = screen->my_field;
-					ctx->captions[idx].channel = screen->my_channel;
-					ctx->captions[idx].base_row = bottom_row;
-					ctx->captions[idx].mode = cc_mode_to_cea(screen->mode);
-					strncpy(ctx->captions[idx].info, "608", 3);
-					ctx->captions[idx].info[3] = '\0';
-					idx++;
-				}
+				ctx->text_storage[idx] = strdup(ev->text);
+				fill_708_caption(&ctx->captions[idx], ev, ctx->text_storage[idx]);
+				idx++;
 			}
 		}
 	}
@@ -320,38 +383,21 @@ static void collect_captions(cea_ctx *ctx)
 	ctx->text_count = idx;
 }
 
-/* Free the linked cc_subtitle chain (except the head which is embedded) */
-static void free_sub_chain(struct cc_subtitle *head)
-{
-	struct cc_subtitle *cur = head->next;
-	while (cur)
-	{
-		struct cc_subtitle *next = cur->next;
-		freep(&cur->data);
-		free(cur);
-		cur = next;
-	}
-	freep(&head->data);
-	memset(head, 0, sizeof(struct cc_subtitle));
-}
-
 void cea_set_log_callback(cea_ctx *ctx, cea_log_callback cb, void *userdata, cea_log_level min_level)
 {
 	if (!ctx)
 		return;
-	ctx->log_cb        = cb;
-	ctx->log_ud        = userdata;
-	ctx->log_min_level = min_level;
-	cea_log_activate(cb, userdata, min_level, ctx->log_debug_mask);
+	ctx->log.cb        = cb;
+	ctx->log.userdata  = userdata;
+	ctx->log.min_level = min_level;
 }
 
 void cea_set_debug_mask(cea_ctx *ctx, int64_t mask)
 {
 	if (!ctx)
 		return;
-	ctx->log_debug_mask = mask;
-	ctx->log_min_level  = CEA_LOG_DEBUG;
-	cea_log_activate(ctx->log_cb, ctx->log_ud, CEA_LOG_DEBUG, mask);
+	ctx->log.debug_mask = mask;
+	ctx->log.min_level  = CEA_LOG_DEBUG;
 }
 
 void cea_set_caption_callback(cea_ctx *ctx, cea_caption_callback cb, void *userdata)
@@ -361,6 +407,8 @@ void cea_set_caption_callback(cea_ctx *ctx, cea_caption_callback cb, void *userd
 	ctx->live_cb = cb;
 	ctx->live_cb_userdata = userdata;
 	memset(ctx->live_screen_start_ms, 0, sizeof(ctx->live_screen_start_ms));
+	memset(ctx->live_708_seq, 0, sizeof(ctx->live_708_seq));
+	memset(ctx->live_708_shown, 0, sizeof(ctx->live_708_shown));
 }
 
 /*
@@ -378,13 +426,15 @@ static int64_t to_abs_pts(cea_ctx *ctx, int64_t rel_ms)
 /*
  * fire_live_callbacks — called at the end of every cea_feed() and cea_flush().
  *
- * Phase 1: drain the completed sub-chains and emit "clear" events (end_ms known).
- *          For CEA-708, also emit a preceding "show" event because there is no
- *          Phase 2 equivalent for the 708 decoder.
+ * Phase 1: drain the caption ring and emit "clear" events (end_ms known).
+ *          For CEA-708, also emit a preceding "show" event if Phase 2 has not
+ *          reported the caption yet (it appeared and ended within one feed).
  *
  * Phase 2: peek at each 608 decoder's current visible screen buffer.  If the
  *          screen has content and current_visible_start_ms has changed since we
  *          last reported it, emit a "show" event immediately (end_ms still 0).
+ *          Likewise render the visible windows of each 708 service whose
+ *          visible_change_seq has moved since we last looked.
  */
 static void fire_live_callbacks(cea_ctx *ctx)
 {
@@ -397,12 +447,15 @@ static void fire_live_callbacks(cea_ctx *ctx)
 	for (int i = 0; i < ctx->caption_count; i++) {
 		cea_caption *cap = &ctx->captions[i];
 
-		if (cap->field == 3) {
-			/* CEA-708: no Phase 2, so fire the "show" event here first */
-			cea_caption show = *cap;
-			show.pts_ms = to_abs_pts(ctx, show.start_ms);
-			show.end_ms = 0;
-			ctx->live_cb(&show, ctx->live_cb_userdata);
+		if (cap->field == 3 && cap->channel >= 1 && cap->channel <= CEA_DTVCC_MAX_SERVICES) {
+			/* CEA-708: fire the "show" event here unless Phase 2 already did */
+			if (!ctx->live_708_shown[cap->channel - 1]) {
+				cea_caption show = *cap;
+				show.pts_ms = to_abs_pts(ctx, show.start_ms);
+				show.end_ms = 0;
+				ctx->live_cb(&show, ctx->live_cb_userdata);
+			}
+			ctx->live_708_shown[cap->channel - 1] = 0;
 		}
 
 		/* Fire the "clear" event */
@@ -417,11 +470,8 @@ static void fire_live_callbacks(cea_ctx *ctx)
 			ctx->live_screen_start_ms[(cap->field - 1) * 2 + (cap->channel - 1)] = 0;
 	}
 
-	/* Sub-chains consumed; free them so cea_get_captions() returns 0 */
-	if (ctx->caption_count > 0) {
-		free_sub_chain(&ctx->sub);
-		free_sub_chain(&ctx->sub_708);
-	}
+	/* Events consumed; release them so cea_get_captions() returns 0 */
+	cc_ring_consume(&ctx->ring, ctx->ring.count);
 
 	/* ---- Phase 2: peek at current EIA-608 visible screen buffers ----
 	 * Order: CC1 (f1/ch1), CC2 (f1/ch2), CC3 (f2/ch1), CC4 (f2/ch2) */
@@ -466,17 +516,57 @@ static void fire_live_callbacks(cea_ctx *ctx)
 		ctx->live_screen_start_ms[f] = c->current_visible_start_ms;
 		free(text);
 	}
+
+	/* ---- Phase 2 (708): render services whose visible windows changed ---- */
+	dtvcc_ctx *dtvcc = ctx->dec->dtvcc;
+	if (!dtvcc)
+		return;
+
+	for (uint64_t active = dtvcc->services_active; active;) {
+		int s = dtvcc_next_service(&active);
+		dtvcc_service_decoder *decoder = dtvcc_service_decoder_of(dtvcc, s);
+		if (!decoder || decoder->visible_change_seq == ctx->live_708_seq[s])
+			continue;
+		ctx->live_708_seq[s] = decoder->visible_change_seq;
+
+		int64_t show_ms = 0;
+		int bottom_row = -1;
+		const char *text = dtvcc_visible_text(dtvcc, decoder, &show_ms, &bottom_row);
+		if (!text) {
+			/* Text we showed went away without becoming a caption
+			 * (e.g. hidden behind another visible window, or reset) */
+			if (ctx->live_708_shown[s]) {
+				cea_caption clr = {0};
+				clr.end_ms  = get_visible_end(ctx->timing, 3);
+				clr.pts_ms  = to_abs_pts(ctx, clr.end_ms);
+				clr.field   = 3;
+				clr.channel = s + 1;
+				strncpy(clr.info, "708", 3);
+				ctx->live_cb(&clr, ctx->live_cb_userdata);
+				ctx->live_708_shown[s] = 0;
+			}
+			continue;
+		}
+
+		cea_caption cap = {0};
+		cap.text      = text;
+		cap.pts_ms    = to_abs_pts(ctx, show_ms);
+		cap.start_ms  = show_ms;
+		cap.end_ms    = 0;
+		cap.field     = 3;
+		cap.channel   = s + 1;
+		cap.base_row  = bottom_row;
+		cap.mode      = CEA_MODE_POPON;
+		strncpy(cap.info, "708", 3);
+		cap.info[3]   = '\0';
+
+		ctx->live_cb(&cap, ctx->live_cb_userdata);
+		ctx->live_708_shown[s] = 1;
+	}
 }
 
 cea_ctx *cea_init(const cea_options *opts)
 {
-	/* Build the parity table */
-	build_parity_table();
-
-	/* Init timing subsystem */
-	static int64_t file_pos = 0;
-	cea_common_timing_init(&file_pos, 0);
-
 	cea_ctx *ctx = (cea_ctx *)calloc(1, sizeof(cea_ctx));
 	if (!ctx)
 		return NULL;
@@ -493,10 +583,11 @@ cea_ctx *cea_init(const cea_options *opts)
 	}
 
 	/* Set up decoder settings */
-	struct cea_decoder_608_settings settings_608 = {0};
-	settings_608.report = ctx->report_608;
-	settings_608.screens_to_process = -1;
-	settings_608.default_color = COL_TRANSPARENT;
+	ctx->settings_608.report = ctx->report_608;
+	ctx->settings_608.screens_to_process = -1;
+	ctx->settings_608.default_color = COL_TRANSPARENT;
+
+	struct cea_common_timing_settings_t settings_timing = {0};
 
 	struct cea_decoder_dtvcc_settings settings_708 = {0};
 	settings_708.report = ctx->report_708;
@@ -521,22 +612,41 @@ cea_ctx *cea_init(const cea_options *opts)
 		settings_708.active_services_count = 1;
 	}
 
+	if (cc_ring_init(&ctx->ring, CEA_CAPTION_RING_INITIAL_CAPACITY, &ctx->log) < 0)
+	{
+		free(ctx->report_608);
+		free(ctx->report_708);
+		free(ctx);
+		return NULL;
+	}
+
 	struct cea_decoders_common_settings_t dec_settings = {0};
-	dec_settings.settings_608 = &settings_608;
+	dec_settings.settings_608 = &ctx->settings_608;
 	dec_settings.settings_dtvcc = &settings_708;
-	dec_settings.extract = 12; /* Always extract both EIA-608 fields and all channels */
+	dec_settings.settings_timing = &settings_timing;
+	dec_settings.disable_608 = opts ? opts->disable_608 : 0;
+	if ((dec_settings.disable_608 & CEA_608_FIELD_1) == CEA_608_FIELD_1)
+		dec_settings.extract = 2;
+	else if ((dec_settings.disable_608 & CEA_608_FIELD_2) == CEA_608_FIELD_2)
+		dec_settings.extract = 1;
+	else
+		dec_settings.extract = 12;
+	dec_settings.log = &ctx->log;
 
 	ctx->dec = init_cc_decode(&dec_settings);
 	if (!ctx->dec)
 	{
+		cc_ring_free(&ctx->ring);
+		free(ctx->report_608);
+		free(ctx->report_708);
 		free(ctx);
 		return NULL;
 	}
 
 	ctx->timing = ctx->dec->timing;
 	ctx->reorder_window_override = opts ? opts->reorder_window : 0;
-	memset(&ctx->sub, 0, sizeof(ctx->sub));
-	memset(&ctx->sub_708, 0, sizeof(ctx->sub_708));
+	ctx->full_packet_scan = opts ? opts->full_packet_scan : 0;
+	ctx->adaptive_reorder = opts ? opts->adaptive_reorder : 0;
 
 	return ctx;
 }
@@ -557,8 +667,9 @@ void cea_free(cea_ctx *ctx)
 	clear_caption_storage(ctx);
 	free(ctx->captions);
 	free(ctx->reorder_buf);
-	free_sub_chain(&ctx->sub);
-	free_sub_chain(&ctx->sub_708);
+	free(ctx->reorder_heap);
+	free(ctx->reorder_free);
+	cc_ring_free(&ctx->ring);
 
 	if (ctx->dec)
 		dinit_cc_decode(&ctx->dec);
@@ -573,8 +684,6 @@ int cea_feed(cea_ctx *ctx, const unsigned char *cc_data, int cc_count, int64_t p
 	if (!ctx || !ctx->dec || !cc_data || cc_count <= 0)
 		return -1;
 
-	cea_log_activate(ctx->log_cb, ctx->log_ud, ctx->log_min_level, ctx->log_debug_mask);
-
 	/* Convert pts_ms to PTS ticks (90kHz clock) */
 	int64_t pts_ticks = (int64_t)pts_ms * 90;
 
@@ -596,47 +705,131 @@ int cea_feed(cea_ctx *ctx, const unsigned char *cc_data, int cc_count, int64_t p
 		ctx->pts_abs_calibrated = 1;
 	}
 
-	/* Point 708 decoder at its own sub chain so it doesn't collide
-	 * with the 608 sub (which uses realloc on sub->data).  The 708
-	 * decoder uses dtvcc->current_sub set here; process_cc_data will
-	 * override it, so we also need the matching change there. */
-	if (ctx->dec->dtvcc)
-		ctx->dec->dtvcc->current_sub = &ctx->sub_708;
-
-	/* Process cc_data -- 608 output goes to ctx->sub,
-	 * 708 output goes to ctx->sub_708 via dtvcc->current_sub */
-	int ret = process_cc_data(ctx->dec, (unsigned char *)cc_data, cc_count, &ctx->sub);
+	/* Process cc_data -- 608 and 708 captions are appended to ctx->ring */
+	int ret = process_cc_data(ctx->dec, cc_data, cc_count, &ctx->ring);
 
 	fire_live_callbacks(ctx);
 
 	return ret;
 }
 
-/* Sort the reorder buffer by PTS and feed all entries via cea_feed */
-static void flush_reorder_buffer(cea_ctx *ctx)
+static int reorder_less(cea_ctx *ctx, int a, int b)
 {
-	if (ctx->reorder_count == 0)
-		return;
+	const struct cc_reorder_entry *ea = &ctx->reorder_buf[a];
+	const struct cc_reorder_entry *eb = &ctx->reorder_buf[b];
+	return ea->pts_ms < eb->pts_ms || (ea->pts_ms == eb->pts_ms && ea->seq < eb->seq);
+}
 
-	/* Insertion sort by PTS (buffer is typically 2-5 entries) */
-	for (int i = 1; i < ctx->reorder_count; i++) {
-		struct cc_reorder_entry key = ctx->reorder_buf[i];
-		int j = i - 1;
-		while (j >= 0 && ctx->reorder_buf[j].pts_ms > key.pts_ms) {
-			ctx->reorder_buf[j + 1] = ctx->reorder_buf[j];
-			j--;
-		}
-		ctx->reorder_buf[j + 1] = key;
+static void reorder_sift_up(cea_ctx *ctx, int i)
+{
+	int *heap = ctx->reorder_heap;
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (!reorder_less(ctx, heap[i], heap[parent]))
+			break;
+		int tmp = heap[i];
+		heap[i] = heap[parent];
+		heap[parent] = tmp;
+		i = parent;
 	}
+}
 
-	/* Feed each entry in PTS order */
-	for (int i = 0; i < ctx->reorder_count; i++) {
-		cea_feed(ctx, ctx->reorder_buf[i].cc_data,
-		              ctx->reorder_buf[i].cc_count,
-		              ctx->reorder_buf[i].pts_ms);
+static void reorder_sift_down(cea_ctx *ctx, int i)
+{
+	int *heap = ctx->reorder_heap;
+	for (;;) {
+		int l = 2 * i + 1, r = l + 1, m = i;
+		if (l < ctx->reorder_count && reorder_less(ctx, heap[l], heap[m]))
+			m = l;
+		if (r < ctx->reorder_count && reorder_less(ctx, heap[r], heap[m]))
+			m = r;
+		if (m == i)
+			break;
+		int tmp = heap[i];
+		heap[i] = heap[m];
+		heap[m] = tmp;
+		i = m;
 	}
+}
+
+/* Queue cc_data for release in PTS order. Returns 0 on success, -1 on OOM. */
+static int reorder_push(cea_ctx *ctx, const unsigned char *cc_data, int cc_count, int64_t pts_ms)
+{
+	if (ctx->reorder_free_count == 0) {
+		int new_cap = ctx->reorder_cap ? ctx->reorder_cap * 2 : 8;
+		struct cc_reorder_entry *buf = realloc(ctx->reorder_buf, new_cap * sizeof(*buf));
+		if (!buf)
+			return -1;
+		ctx->reorder_buf = buf;
+		int *heap = realloc(ctx->reorder_heap, new_cap * sizeof(int));
+		if (!heap)
+			return -1;
+		ctx->reorder_heap = heap;
+		int *free_slots = realloc(ctx->reorder_free, new_cap * sizeof(int));
+		if (!free_slots)
+			return -1;
+		ctx->reorder_free = free_slots;
+		/* All old slots are in use, so the new ones are the free ones */
+		for (int i = new_cap - 1; i >= ctx->reorder_cap; i--)
+			ctx->reorder_free[ctx->reorder_free_count++] = i;
+		ctx->reorder_cap = new_cap;
+	}
+
+	int slot = ctx->reorder_free[--ctx->reorder_free_count];
+	struct cc_reorder_entry *e = &ctx->reorder_buf[slot];
+	e->pts_ms = pts_ms;
+	e->seq = ctx->reorder_seq++;
+	e->cc_count = cc_count;
+	memcpy(e->cc_data, cc_data, cc_count * 3);
+
+	ctx->reorder_heap[ctx->reorder_count++] = slot;
+	reorder_sift_up(ctx, ctx->reorder_count - 1);
+	return 0;
+}
+
+/* Feed the entry with the lowest PTS via cea_feed and release its slot */
+static void reorder_pop_feed(cea_ctx *ctx)
+{
+	int slot = ctx->reorder_heap[0];
+	ctx->reorder_heap[0] = ctx->reorder_heap[--ctx->reorder_count];
+	reorder_sift_down(ctx, 0);
+	ctx->reorder_free[ctx->reorder_free_count++] = slot;
 
-	ctx->reorder_count = 0;
+	struct cc_reorder_entry *e = &ctx->reorder_buf[slot];
+	cea_feed(ctx, e->cc_data, e->cc_count, e->pts_ms);
+}
+
+/* Record pts_ms in the inversion history and return the window it calls
+ * for: the deepest inversion seen in the history, or at least `guess`
+ * until the history has filled. */
+static int adaptive_reorder_window(cea_ctx *ctx, int64_t pts_ms, int guess)
+{
+	int n = ctx->reorder_hist_count;
+	int depth = 0;
+	for (int i = 0; i < n; i++)
+		depth += ctx->reorder_hist_pts[i] > pts_ms;
+
+	ctx->reorder_hist_pts[ctx->reorder_hist_pos] = pts_ms;
+	ctx->reorder_hist_depth[ctx->reorder_hist_pos] = (unsigned char)depth;
+	ctx->reorder_hist_pos = (ctx->reorder_hist_pos + 1) % CEA_REORDER_HISTORY;
+	if (n < CEA_REORDER_HISTORY)
+		ctx->reorder_hist_count = ++n;
+
+	int window = 0;
+	for (int i = 0; i < n; i++) {
+		if (ctx->reorder_hist_depth[i] > window)
+			window = ctx->reorder_hist_depth[i];
+	}
+	if (n < CEA_REORDER_HISTORY && window < guess)
+		window = guess;
+	return window;
+}
+
+/* Feed all buffered entries via cea_feed in PTS order */
+static void flush_reorder_buffer(cea_ctx *ctx)
+{
+	while (ctx->reorder_count > 0)
+		reorder_pop_feed(ctx);
 }
 
 int cea_set_demuxer(cea_ctx *ctx, cea_codec_type codec,
@@ -654,62 +847,116 @@ int cea_set_demuxer(cea_ctx *ctx, cea_codec_type codec,
 	ctx->packaging = packaging;
 	ctx->nal_length_size = 0;
 	ctx->max_reorder_frames = -1;
+	ctx->reorder_exact = 0;
+	ctx->reorder_hist_count = 0;
+	ctx->reorder_hist_pos = 0;
+	cea_demux_sps_cache_init(&ctx->sps_cache);
 	ctx->demuxer_configured = 1;
 
 	/* Try to parse reorder window from extradata (SPS) */
 	if (codec == CEA_CODEC_H264 && extradata && extradata_size > 0) {
-		int mr = cea_demux_h264_parse_extradata_reorder(extradata, extradata_size);
+		int exact;
+		int mr = cea_demux_h264_parse_extradata_reorder(extradata, extradata_size, &exact);
 		if (mr >= 0) {
 			ctx->max_reorder_frames = mr;
-			mprint("SPS: max_num_reorder_frames=%d\n", mr);
+			ctx->reorder_exact = exact;
+			mprint(&ctx->log, "SPS: max_num_reorder_frames=%d\n", mr);
 		}
+	} else if (codec == CEA_CODEC_HEVC && extradata && extradata_size > 0) {
+		int nal_length_size;
+		int mr = cea_demux_hevc_parse_extradata_reorder(extradata, extradata_size, &nal_length_size);
+		if (mr >= 0) {
+			ctx->max_reorder_frames = mr;
+			ctx->reorder_exact = 1;
+			mprint(&ctx->log, "SPS: sps_max_num_reorder_pics=%d\n", mr);
+		}
+		/* hvcC states the length size, no need to guess it from packets */
+		if (packaging == CEA_PACKAGING_AVCC)
+			ctx->nal_length_size = nal_length_size;
+	} else if (codec == CEA_CODEC_AV1) {
+		/* Each AV1 temporal unit shows exactly one frame, so packets
+		 * already arrive in presentation order */
+		ctx->max_reorder_frames = 0;
+		ctx->reorder_exact = 1;
 	}
 
 	return 0;
 }
 
-int cea_feed_packet(cea_ctx *ctx, const unsigned char *pkt_data,
-                         int pkt_size, int64_t pts_ms)
+/* Run the configured demuxer over one packet and track the reorder window
+ * it reports. Returns the number of cc_data triplets written to cc_out. */
+static int demux_packet(cea_ctx *ctx, const unsigned char *pkt_data, int pkt_size,
+                        unsigned char *cc_out)
 {
-	if (!ctx || !pkt_data || pkt_size <= 0 || !ctx->demuxer_configured)
-		return -1;
-
-	unsigned char cc_data[31 * 3];
 	cea_demux_result result;
 
-	if (ctx->codec == CEA_CODEC_H264) {
-		result = cea_demux_h264_extract_cc(
+	if (ctx->codec == CEA_CODEC_H264 || ctx->codec == CEA_CODEC_HEVC) {
+		result = cea_demux_nal_extract_cc(
+			ctx->codec == CEA_CODEC_HEVC ? CEA_NAL_HEVC : CEA_NAL_H264,
 			ctx->packaging == CEA_PACKAGING_AVCC,
 			&ctx->nal_length_size,
-			pkt_data, pkt_size, cc_data);
+			!ctx->full_packet_scan,
+			&ctx->sps_cache,
+			pkt_data, pkt_size, cc_out);
+	} else if (ctx->codec == CEA_CODEC_AV1) {
+		result = cea_demux_av1_extract_cc(pkt_data, pkt_size, cc_out);
 	} else {
 		result = cea_demux_mpeg2_extract_cc(
-			pkt_data, pkt_size, cc_data);
+			pkt_data, pkt_size, !ctx->full_packet_scan, cc_out);
 	}
 
-	/* Update reorder window from stream if not yet known */
-	if (result.reorder_window >= 0 && ctx->max_reorder_frames < 0)
+	/* Update reorder window from stream. H.264/HEVC report it whenever an SPS
+	 * changes, so a splice or rendition switch replaces a stale window. */
+	if (result.reorder_window >= 0 && result.reorder_window != ctx->max_reorder_frames) {
+		if (ctx->max_reorder_frames >= 0)
+			mprint(&ctx->log, "SPS changed: max_num_reorder_frames=%d\n", result.reorder_window);
 		ctx->max_reorder_frames = result.reorder_window;
+	}
+	if (result.reorder_window >= 0)
+		ctx->reorder_exact = result.reorder_exact;
+
+	return result.cc_count;
+}
+
+int cea_feed_packet(cea_ctx *ctx, const unsigned char *pkt_data,
+                         int pkt_size, int64_t pts_ms)
+{
+	return cea_feed_packet_ex(ctx, pkt_data, pkt_size, pts_ms, 0, 0);
+}
+
+int cea_feed_packet_ex(cea_ctx *ctx, const unsigned char *pkt_data,
+                       int pkt_size, int64_t pts_ms, int64_t dts_ms, int flags)
+{
+	if (!ctx || !pkt_data || pkt_size <= 0 || !ctx->demuxer_configured)
+		return -1;
+
+	/* Timestamps jump here: nothing buffered can be reordered past this packet */
+	if (flags & CEA_PACKET_DISCONTINUITY) {
+		flush_reorder_buffer(ctx);
+		ctx->reorder_hist_count = 0;
+		ctx->reorder_hist_pos = 0;
+	}
+
+	unsigned char cc_data[31 * 3];
+	int cc_count = demux_packet(ctx, pkt_data, pkt_size, cc_data);
 
 	/* Add cc_data to reorder buffer */
-	if (result.cc_count > 0) {
-		if (ctx->reorder_count >= ctx->reorder_cap) {
-			int new_cap = ctx->reorder_cap ? ctx->reorder_cap * 2 : 8;
-			struct cc_reorder_entry *tmp = realloc(ctx->reorder_buf,
-				new_cap * sizeof(*tmp));
-			if (!tmp)
-				return -1;
-			ctx->reorder_buf = tmp;
-			ctx->reorder_cap = new_cap;
-		}
-		ctx->reorder_buf[ctx->reorder_count].pts_ms = pts_ms;
-		ctx->reorder_buf[ctx->reorder_count].cc_count = result.cc_count;
-		memcpy(ctx->reorder_buf[ctx->reorder_count].cc_data, cc_data, result.cc_count * 3);
-		ctx->reorder_count++;
+	if (cc_count > 0 && reorder_push(ctx, cc_data, cc_count, pts_ms) < 0)
+		return -1;
+
+	if (flags & CEA_PACKET_DTS_VALID) {
+		/* Every packet still to come has pts >= its dts > dts_ms, so all
+		 * entries presented up to dts_ms are final. */
+		while (ctx->reorder_count > 0 && ctx->reorder_buf[ctx->reorder_heap[0]].pts_ms <= dts_ms)
+			reorder_pop_feed(ctx);
+		while (ctx->reorder_count > CEA_REORDER_DTS_CAP)
+			reorder_pop_feed(ctx);
+		return 0;
 	}
 
 	/* Determine reorder window.
-	 * Priority: user override > SPS max_num_reorder_frames > default 4. */
+	 * Priority: user override > SPS max_num_reorder_frames > default 4.
+	 * In adaptive mode a guessed window is replaced by the observed one. */
 	int window;
 	if (ctx->reorder_window_override > 0)
 		window = ctx->reorder_window_override;
@@ -717,39 +964,34 @@ int cea_feed_packet(cea_ctx *ctx, const unsigned char *pkt_data,
 		window = ctx->max_reorder_frames;
 	else
 		window = 4;
-	while (ctx->reorder_count > window) {
-		/* Find entry with smallest PTS */
-		int min_idx = 0;
-		for (int i = 1; i < ctx->reorder_count; i++) {
-			if (ctx->reorder_buf[i].pts_ms < ctx->reorder_buf[min_idx].pts_ms)
-				min_idx = i;
-		}
-		/* Feed it */
-		cea_feed(ctx, ctx->reorder_buf[min_idx].cc_data,
-		         ctx->reorder_buf[min_idx].cc_count,
-		         ctx->reorder_buf[min_idx].pts_ms);
-		/* Remove from buffer by swapping with last */
-		ctx->reorder_buf[min_idx] = ctx->reorder_buf[ctx->reorder_count - 1];
-		ctx->reorder_count--;
-	}
+	if (ctx->adaptive_reorder && ctx->reorder_window_override <= 0 && !ctx->reorder_exact)
+		window = adaptive_reorder_window(ctx, pts_ms, window);
+	while (ctx->reorder_count > window)
+		reorder_pop_feed(ctx);
 
 	return 0;
 }
 
+int cea_extract_cc_data(cea_ctx *ctx, const unsigned char *pkt_data, int pkt_size,
+                        const unsigned char **cc_data, int *cc_count)
+{
+	if (!ctx || !pkt_data || pkt_size <= 0 || !cc_data || !cc_count || !ctx->demuxer_configured)
+		return -1;
+
+	*cc_count = demux_packet(ctx, pkt_data, pkt_size, ctx->extract_buf);
+	*cc_data = ctx->extract_buf;
+	return 0;
+}
+
 int cea_flush(cea_ctx *ctx)
 {
 	if (!ctx || !ctx->dec)
 		return -1;
 
-	cea_log_activate(ctx->log_cb, ctx->log_ud, ctx->log_min_level, ctx->log_debug_mask);
-
 	/* Flush any pending reorder buffer entries */
 	flush_reorder_buffer(ctx);
 
-	if (ctx->dec->dtvcc)
-		ctx->dec->dtvcc->current_sub = &ctx->sub_708;
-
-	flush_cc_decode(ctx->dec, &ctx->sub);
+	flush_cc_decode(ctx->dec, &ctx->ring);
 
 	/* Drain any captions produced by the flush (e.g. final EDM) */
 	fire_live_callbacks(ctx);
@@ -765,11 +1007,91 @@ int cea_get_captions(cea_ctx *ctx, cea_caption *out, int max_captions)
 	collect_captions(ctx);
 
 	int n = ctx->caption_count < max_captions ? ctx->caption_count : max_captions;
-	memcpy(out, ctx->captions, n * sizeof(cea_caption));
+	if (n > 0)
+		memcpy(out, ctx->captions, n * sizeof(cea_caption));
+
+	/* Release the ring events now that we've extracted them */
+	cc_ring_consume(&ctx->ring, ctx->ring.count);
+
+	return n;
+}
+
+int cea_get_captions_into(cea_ctx *ctx, cea_caption *out, int max_captions,
+                          char *arena, size_t arena_len, size_t *arena_used)
+{
+	if (arena_used)
+		*arena_used = 0;
+	if (!ctx || !out || max_captions <= 0 || (!arena && arena_len))
+		return -1;
+
+	int n = 0;
+	size_t used = 0;
+	int full = 0;
+
+	/* Same order as collect_captions(): 608 captions first, then 708.
+	 * Events handed out are marked, and released once every event before
+	 * them is too, so a caller whose buffers fill up gets the rest next time. */
+	for (int pass = 0; pass < 2 && !full; pass++)
+	{
+		for (unsigned int i = 0; i < ctx->ring.count; i++)
+		{
+			struct cc_caption_event *ev = cc_ring_at(&ctx->ring, i);
+			if (ev->collected || ev->type != (pass == 0 ? CC_608 : CC_TEXT))
+				continue;
+			if (n == max_captions)
+			{
+				full = 1;
+				break;
+			}
+
+			struct text_out text;
+			text.buf = arena + used;
+			text.cap = arena_len - used;
+			text.len = 0;
+
+			if (ev->type == CC_608)
+			{
+				int bottom_row = -1;
+				if (render_608_text(&ev->screen, &text, &bottom_row) < 0)
+				{
+					full = 1;
+					break;
+				}
+				if (text.len == 0)
+				{
+					/* Nothing visible on this screen, same as cea_get_captions() */
+					ev->collected = 1;
+					continue;
+				}
+				fill_608_caption(&out[n], &ev->screen, text.buf, bottom_row);
+			}
+			else
+			{
+				if (text.cap == 0 || text_put(&text, ev->text, strlen(ev->text)) < 0)
+				{
+					full = 1;
+					break;
+				}
+				text.buf[text.len] = '\0';
+				fill_708_caption(&out[n], ev, text.buf);
+			}
 
-	/* Free the subtitle chains now that we've extracted */
-	free_sub_chain(&ctx->sub);
-	free_sub_chain(&ctx->sub_708);
+			used += text.len + 1;
+			n++;
+			ev->collected = 1;
+		}
+	}
+
+	unsigned int done = 0;
+	while (done < ctx->ring.count && cc_ring_at(&ctx->ring, done)->collected)
+		done++;
+	cc_ring_consume(&ctx->ring, done);
 
+	if (arena_used)
+		*arena_used = used;
+
+	/* The next caption does not fit even into an empty arena */
+	if (n == 0 && full)
+		return -1;
 	return n;
 }
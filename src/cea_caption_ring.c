@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#include "cea_caption_ring.h"
+#include "cea_common_common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int cc_ring_init(struct cc_caption_ring *ring, unsigned int capacity, const struct cea_logger *log)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->log = log;
+	ring->events = (struct cc_caption_event *)calloc(capacity, sizeof(struct cc_caption_event));
+	if (!ring->events)
+		return -1;
+	ring->capacity = capacity;
+	return 0;
+}
+
+void cc_ring_free(struct cc_caption_ring *ring)
+{
+	for (unsigned int i = 0; i < ring->capacity; i++)
+		free(ring->events[i].text);
+	free(ring->events);
+	memset(ring, 0, sizeof(*ring));
+}
+
+/* Double the capacity, unwrapping the pending events to the start of the new array */
+static int cc_ring_grow(struct cc_caption_ring *ring)
+{
+	unsigned int new_capacity = ring->capacity ? ring->capacity * 2 : CEA_CAPTION_RING_INITIAL_CAPACITY;
+	struct cc_caption_event *events = (struct cc_caption_event *)calloc(new_capacity, sizeof(struct cc_caption_event));
+	if (!events)
+		return -1;
+
+	for (unsigned int i = 0; i < ring->capacity; i++)
+		events[i] = ring->events[(ring->head + i) % ring->capacity];
+	free(ring->events);
+
+	dbg_print(ring->log, CEA_DMT_GENERIC_NOTICES, "Caption ring grown to %u events\n", new_capacity);
+
+	ring->events = events;
+	ring->capacity = new_capacity;
+	ring->head = 0;
+	return 0;
+}
+
+/* Append a slot at the tail and return it. Its text buffer is kept from the previous use. */
+struct cc_caption_event *cc_ring_push(struct cc_caption_ring *ring)
+{
+	if (ring->count == ring->capacity && cc_ring_grow(ring) < 0)
+	{
+		mprint(ring->log, "Out of memory while growing the caption ring, caption dropped\n");
+		return NULL;
+	}
+
+	struct cc_caption_event *event = &ring->events[(ring->head + ring->count) % ring->capacity];
+	ring->count++;
+
+	event->start_time = 0;
+	event->end_time = 0;
+	event->flags = 0;
+	event->mode = CEA_MODE_UNKNOWN;
+	event->info[0] = '\0';
+	event->collected = 0;
+	return event;
+}
+
+/* i-th pending event, oldest first */
+struct cc_caption_event *cc_ring_at(struct cc_caption_ring *ring, unsigned int i)
+{
+	return &ring->events[(ring->head + i) % ring->capacity];
+}
+
+/* Release the n oldest events */
+void cc_ring_consume(struct cc_caption_ring *ring, unsigned int n)
+{
+	if (n >= ring->count)
+	{
+		ring->head = 0;
+		ring->count = 0;
+		return;
+	}
+	ring->head = (ring->head + n) % ring->capacity;
+	ring->count -= n;
+}
+
+/* Take back the most recent push, e.g. when filling it in failed */
+void cc_ring_drop_last(struct cc_caption_ring *ring)
+{
+	if (ring->count)
+		ring->count--;
+}
+
+/* Make the event's text buffer hold at least size bytes, growing it only when it is too small */
+int cc_ring_reserve_text(struct cc_caption_ring *ring, struct cc_caption_event *event, size_t size)
+{
+	if (size > event->text_cap)
+	{
+		char *text = (char *)realloc(event->text, size);
+		if (!text)
+		{
+			mprint(ring->log, "Out of memory while storing caption text\n");
+			return -1;
+		}
+		event->text = text;
+		event->text_cap = size;
+	}
+	return 0;
+}
+
+/* Copy len bytes of str into the event's text buffer */
+int cc_ring_set_text(struct cc_caption_ring *ring, struct cc_caption_event *event, const char *str, size_t len)
+{
+	if (cc_ring_reserve_text(ring, event, len + 1) < 0)
+		return -1;
+	memcpy(event->text, str, len);
+	event->text[len] = '\0';
+	return 0;
+}
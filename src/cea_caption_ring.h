@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#ifndef CEA_CAPTION_RING_H
+#define CEA_CAPTION_RING_H
+
+#include "cea_decoders_structs.h"
+
+#include <stddef.h>
+
+#define CEA_CAPTION_RING_INITIAL_CAPACITY 16
+
+/**
+ * A completed caption waiting to be collected.
+ * 608 captions keep a copy of the screen and are rendered on collection,
+ * 708 captions keep their rendered text in a buffer owned by the slot.
+ */
+struct cc_caption_event
+{
+	enum subtype type;
+	int64_t start_time;
+	int64_t end_time;
+	int flags; // 708: bottom row of the caption
+	cea_mode mode;
+	char info[4];
+	int collected; // already returned by cea_get_captions_into(), waiting to be consumed
+	struct eia608_screen screen; // CC_608
+	char *text;		     // CC_TEXT, reused by later events in this slot
+	size_t text_cap;
+};
+
+/**
+ * FIFO of caption events shared by the 608 and 708 decoders of a context.
+ * Slots and their text buffers are allocated up front and reused, so
+ * emitting a caption does not allocate. The ring only grows if the
+ * consumer lets more than `capacity` events pile up.
+ */
+struct cc_caption_ring
+{
+	struct cc_caption_event *events;
+	unsigned int capacity;
+	unsigned int head; // index of the oldest event
+	unsigned int count;
+	const struct cea_logger *log;
+};
+
+int cc_ring_init(struct cc_caption_ring *ring, unsigned int capacity, const struct cea_logger *log);
+void cc_ring_free(struct cc_caption_ring *ring);
+struct cc_caption_event *cc_ring_push(struct cc_caption_ring *ring);
+struct cc_caption_event *cc_ring_at(struct cc_caption_ring *ring, unsigned int i);
+void cc_ring_consume(struct cc_caption_ring *ring, unsigned int n);
+void cc_ring_drop_last(struct cc_caption_ring *ring);
+int cc_ring_reserve_text(struct cc_caption_ring *ring, struct cc_caption_event *event, size_t size);
+int cc_ring_set_text(struct cc_caption_ring *ring, struct cc_caption_event *event, const char *str, size_t len);
+
+#endif /* CEA_CAPTION_RING_H */
@@ -17,35 +17,29 @@
 
 /* ---- Callback-based logging ---- */
 
-static cea_log_callback s_log_cb     = NULL;
-static void            *s_log_ud     = NULL;
-static cea_log_level    s_min_level  = CEA_LOG_INFO;
-int64_t                 cea_log_debug_mask = 0;
-
-/* Activate the logger state for the current context (called at feed/flush entry). */
-void cea_log_activate(cea_log_callback cb, void *ud, cea_log_level min_level, int64_t debug_mask)
+void cea_log(const struct cea_logger *log, cea_log_level level, const char *fmt, ...)
 {
-	s_log_cb         = cb;
-	s_log_ud         = ud;
-	s_min_level      = min_level;
-	cea_log_debug_mask = debug_mask;
-}
-
-void cea_log(cea_log_level level, const char *fmt, ...)
-{
-	if (!s_log_cb || level < s_min_level)
+	if (!log || !log->cb || level < log->min_level)
 		return;
 	char buf[4096];
 	va_list ap;
 	va_start(ap, fmt);
 	vsnprintf(buf, sizeof(buf), fmt, ap);
 	va_end(ap);
-	s_log_cb(level, buf, s_log_ud);
+	log->cb(level, buf, log->userdata);
 }
 
 /* ---- Parity & utility ---- */
 
-int cc608_parity_table[256];
+/* 1 if the byte (including bit 7) has odd parity. Built at compile time so
+ * that concurrent cea_init() calls never write shared memory. */
+#define P2(n) n, n ^ 1, n ^ 1, n
+#define P4(n) P2(n), P2(n ^ 1), P2(n ^ 1), P2(n)
+#define P6(n) P4(n), P4(n ^ 1), P4(n ^ 1), P4(n)
+const unsigned char cc608_parity_table[256] = {P6(0), P6(1), P6(1), P6(0)};
+#undef P2
+#undef P4
+#undef P6
 
 
 /* Converts the given milli to separate hours,minutes,seconds and ms variables
@@ -73,35 +67,6 @@ void freep(void *arg)
 	}
 }
 
-int add_cc_sub_text(struct cc_subtitle *sub, char *str, int64_t start_time,
-		    int64_t end_time, char *info, cea_mode mode)
-{
-	if (str == NULL || strlen(str) == 0)
-		return 0;
-	if (sub->nb_data)
-	{
-		for (; sub->next; sub = sub->next)
-			;
-		sub->next = (struct cc_subtitle *)malloc(sizeof(struct cc_subtitle));
-		if (!sub->next)
-			return -1;
-		sub = sub->next;
-	}
-
-	sub->type = CC_TEXT;
-	sub->data = strdup(str);
-	sub->nb_data = str ? strlen(str) : 0;
-	sub->start_time = start_time;
-	sub->end_time = end_time;
-	if (info)
-		strncpy(sub->info, info, 4);
-	sub->mode = mode;
-	sub->got_output = 1;
-	sub->next = NULL;
-
-	return 0;
-}
-
 // returns 1 if odd parity and 0 if even parity
 int cc608_parity(unsigned int byte)
 {
@@ -115,20 +80,3 @@ int cc608_parity(unsigned int byte)
 
 	return ones & 1;
 }
-
-void cc608_build_parity_table(int *parity_table)
-{
-	unsigned int byte;
-	int parity_v;
-	for (byte = 0; byte <= 127; byte++)
-	{
-		parity_v = cc608_parity(byte);
-		parity_table[byte] = parity_v;
-		parity_table[byte | 0x80] = !parity_v;
-	}
-}
-
-void build_parity_table(void)
-{
-	cc608_build_parity_table(cc608_parity_table);
-}
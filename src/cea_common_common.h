@@ -34,31 +34,31 @@
 #define EXIT_NOT_ENOUGH_MEMORY 500
 #define CEA_COMMON_EXIT_BUG_BUG 1000
 
-/* Single logging function -- all logging goes through here */
-void cea_log(cea_log_level level, const char *fmt, ...);
-
-/* Active debug mask (synced from context on each feed/flush entry) */
-extern int64_t cea_log_debug_mask;
+/* Logger state. Owned by the cea_ctx; decoders keep a pointer to it */
+struct cea_logger
+{
+	cea_log_callback cb;
+	void *userdata;
+	cea_log_level min_level;
+	int64_t debug_mask;
+};
 
-/* Activate the logger state for the current context */
-void cea_log_activate(cea_log_callback cb, void *ud, cea_log_level min_level, int64_t debug_mask);
+/* Single logging function -- all logging goes through here */
+void cea_log(const struct cea_logger *log, cea_log_level level, const char *fmt, ...);
 
 /* Convenience wrappers */
-#define mprint(...) cea_log(CEA_LOG_INFO, __VA_ARGS__)
-#define dbg_print(mask, ...) do { if (cea_log_debug_mask & (mask)) cea_log(CEA_LOG_DEBUG, __VA_ARGS__); } while (0)
-#define fatal(code, ...) do { cea_log(CEA_LOG_FATAL, __VA_ARGS__); exit(code); } while (0)
+#define mprint(log, ...) cea_log(log, CEA_LOG_INFO, __VA_ARGS__)
+#define dbg_print(log, mask, ...) do { if ((log) && ((log)->debug_mask & (mask))) cea_log(log, CEA_LOG_DEBUG, __VA_ARGS__); } while (0)
+#define fatal(log, code, ...) do { cea_log(log, CEA_LOG_FATAL, __VA_ARGS__); exit(code); } while (0)
 
 /* Declarations */
 int cc608_parity(unsigned int byte);
 void millis_to_time(int64_t milli, unsigned *hours, unsigned *minutes, unsigned *seconds, unsigned *ms);
 
 void freep(void *arg);
-unsigned char *debug_608_to_ASC(unsigned char *ccdata, int channel);
-int add_cc_sub_text(struct cc_subtitle *sub, char *str, int64_t start_time,
-		    int64_t end_time, char *info, cea_mode mode);
+unsigned char *debug_608_to_ASC(unsigned char *ccdata, int channel, unsigned char *output);
 
-extern int cc608_parity_table[256];
-void build_parity_table(void);
+extern const unsigned char cc608_parity_table[256];
 
 #ifndef VERSION
 #define VERSION "cea-0.1"
@@ -18,21 +18,5 @@ enum subtype
 	CC_TEXT,
 };
 
-struct cc_subtitle
-{
-	void *data;
-	unsigned int nb_data;
-	enum subtype type;
-
-	int64_t start_time;
-	int64_t end_time;
-
-	int flags;
-	int got_output;
-
-	cea_mode mode;
-	char info[4];
-
-	struct cc_subtitle *next;
-};
+struct cc_caption_ring; // Caption output of a context, see cea_caption_ring.h
 #endif
@@ -17,36 +17,13 @@
  * in ms using PTS time information.
  */
 
-// Count 608 (per field) and 708 blocks since last set_fts() call
-int cb_field1, cb_field2, cb_708;
-
-int MPEG_CLOCK_FREQ = 90000; // This "constant" is part of the standard
-
-int max_dif = 5;
-unsigned pts_big_change;
-
-double current_fps = (double)30000.0 / 1001; /* 29.97 */
-
-int frames_since_ref_time = 0;
-unsigned total_frames_count;
-
-struct cea_common_timing_settings_t cea_common_timing_settings;
-
 /* Implemented in timing_impl.c */
 void cea_set_current_pts(struct cea_common_timing_ctx *ctx, int64_t pts);
 int cea_set_fts(struct cea_common_timing_ctx *ctx);
 int64_t cea_get_fts(struct cea_common_timing_ctx *ctx, int current_field);
 int64_t cea_get_visible_start(struct cea_common_timing_ctx *ctx, int current_field);
 int64_t cea_get_visible_end(struct cea_common_timing_ctx *ctx, int current_field);
-char *cea_print_mstime_static(int64_t mstime, char *buf);
-
-void cea_common_timing_init(int64_t *file_position, int no_sync)
-{
-	cea_common_timing_settings.disable_sync_check = 0;
-	cea_common_timing_settings.is_elementary_stream = 0;
-	cea_common_timing_settings.file_position = file_position;
-	cea_common_timing_settings.no_sync = no_sync;
-}
+char *cea_print_mstime(int64_t mstime, char *buf);
 
 void dinit_timing_ctx(struct cea_common_timing_ctx **arg)
 {
@@ -81,7 +58,18 @@ struct cea_common_timing_ctx *init_timing_ctx(struct cea_common_timing_settings_
 	ctx->fts_global = 0;
 	ctx->pts_reset = 0;
 
-	(void)cfg;
+	ctx->cb_field1 = 0;
+	ctx->cb_field2 = 0;
+	ctx->cb_708 = 0;
+
+	ctx->max_dif = 5;
+	ctx->pts_big_change = 0;
+	ctx->current_fps = (double)30000.0 / 1001; /* 29.97 */
+	ctx->frames_since_ref_time = 0;
+	ctx->total_frames_count = 0;
+
+	ctx->settings = *cfg;
+	ctx->log = NULL;
 	return ctx;
 }
 
@@ -118,8 +106,7 @@ size_t print_mstime_buff(int64_t mstime, char *fmt, char *buf)
 	return (size_t)snprintf(buf + signoffset, max_time_len, fmt, hh, mm, ss, ms);
 }
 
-char *print_mstime_static(int64_t mstime)
+char *print_mstime(int64_t mstime, char *buf)
 {
-	static char buf[15];
-	return cea_print_mstime_static(mstime, buf);
+	return cea_print_mstime(mstime, buf);
 }
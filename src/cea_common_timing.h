@@ -11,14 +11,16 @@
 
 #include "cea_common_constants.h"
 
+struct cea_logger;
+
+#define MPEG_CLOCK_FREQ 90000 // This constant is part of the standard
+
 struct cea_common_timing_settings_t
 {
 	int disable_sync_check;	  // If 1, timeline jumps will be ignored. This is important in several input formats that are assumed to have correct timing, no matter what.
 	int no_sync;		  // If 1, there will be no sync at all. Mostly useful for debugging.
 	int is_elementary_stream; // Needs to be set, as it's used in set_fts.
-	int64_t *file_position;	  // The position of the file
 };
-extern struct cea_common_timing_settings_t cea_common_timing_settings;
 
 struct cea_common_timing_ctx
 {
@@ -43,12 +45,19 @@ struct cea_common_timing_ctx
 	int64_t sync_pts2fts_fts;
 	int64_t sync_pts2fts_pts;
 	int pts_reset; // 0 = No, 1 = Yes. PTS resets when current_pts is lower than prev
-};
 
-// Count 608 (per field) and 708 blocks since last set_fts() call
-extern int cb_field1, cb_field2, cb_708;
+	// Count 608 (per field) and 708 blocks since last set_fts() call
+	int cb_field1, cb_field2, cb_708;
 
-void cea_common_timing_init(int64_t *file_position, int no_sync);
+	int max_dif;		     // Largest PTS step (in seconds) not treated as a jump
+	unsigned pts_big_change;     // Set once a PTS jump has been seen
+	double current_fps;
+	int frames_since_ref_time;
+	unsigned total_frames_count;
+
+	struct cea_common_timing_settings_t settings;
+	const struct cea_logger *log;
+};
 
 void dinit_timing_ctx(struct cea_common_timing_ctx **arg);
 struct cea_common_timing_ctx *init_timing_ctx(struct cea_common_timing_settings_t *cfg);
@@ -56,7 +65,8 @@ struct cea_common_timing_ctx *init_timing_ctx(struct cea_common_timing_settings_
 void set_current_pts(struct cea_common_timing_ctx *ctx, int64_t pts);
 int set_fts(struct cea_common_timing_ctx *ctx);
 int64_t get_fts(struct cea_common_timing_ctx *ctx, int current_field);
-char *print_mstime_static(int64_t mstime);
+#define CEA_MSTIME_BUF_SIZE 15 // "-HH:MM:SS:mmm" plus terminator
+char *print_mstime(int64_t mstime, char *buf);
 size_t print_mstime_buff(int64_t mstime, char *fmt, char *buf);
 
 #endif
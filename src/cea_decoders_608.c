@@ -13,15 +13,12 @@
 #include "cea_common_timing.h"
 #include "cea_decoders_structs.h"
 #include "cea_decoders_common.h"
+#include "cea_caption_ring.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 
-static const int rowdata[] = {11, -1, 1, 2, 3, 4, 12, 13, 14, 15, 5, 6, 7, 8, 9, 10};
-// Relationship between the first PAC byte and the row number
-int in_xds_mode = 0;
-
 // unsigned char str[2048]; // Another generic general purpose buffer
 
 const unsigned char pac2_attribs[][3] = // Color, font, ident
@@ -103,21 +100,18 @@ const char *color_text[MAX_COLOR][2] =
 	{"black", ""},
 	{"transparent", ""}};
 
+static void clear_eia608_row(cea_decoder_608_context *context, struct eia608_screen *data, int row)
+{
+	memset(data->characters[row], ' ', CEA_DECODER_608_SCREEN_WIDTH);
+	data->characters[row][CEA_DECODER_608_SCREEN_WIDTH] = 0;
+	memset(data->styles[row], CEA_608_STYLE(context->settings->default_color, FONT_REGULAR), CEA_DECODER_608_SCREEN_WIDTH + 1);
+	data->row_used &= ~CEA_608_ROW_BIT(row);
+}
+
 void clear_eia608_cc_buffer(cea_decoder_608_context *context, struct eia608_screen *data)
 {
 	for (int i = 0; i < CEA_DECODER_608_SCREEN_ROWS; i++)
-	{
-		memset(data->characters[i], ' ', CEA_DECODER_608_SCREEN_WIDTH);
-		data->characters[i][CEA_DECODER_608_SCREEN_WIDTH] = 0;
-
-		for (int j = 0; j < CEA_DECODER_608_SCREEN_WIDTH + 1; ++j)
-		{
-			data->colors[i][j] = context->settings->default_color;
-			data->fonts[i][j] = FONT_REGULAR;
-		}
-
-		data->row_used[i] = 0;
-	}
+		clear_eia608_row(context, data, i);
 	data->empty = 1;
 	data->start_time = 0;
 	data->end_time = 0;
@@ -130,7 +124,8 @@ void cea_decoder_608_dinit_library(void **ctx)
 cea_decoder_608_context *cea_decoder_608_init_library(struct cea_decoder_608_settings *settings, int channel,
 						      int field, int *halt,
 						      int cc_to_stdout,
-						      struct cea_common_timing_ctx *timing)
+						      struct cea_common_timing_ctx *timing,
+						      const struct cea_logger *log)
 {
 	cea_decoder_608_context *data = NULL;
 
@@ -141,8 +136,6 @@ cea_decoder_608_context *cea_decoder_608_init_library(struct cea_decoder_608_set
 	data->cursor_column = 0;
 	data->cursor_row = 0;
 	data->visible_buffer = 1;
-	data->last_c1 = 0;
-	data->last_c2 = 0;
 	data->mode = MODE_POPON;
 	// data->current_visible_start_cc=0;
 	data->current_visible_start_ms = 0;
@@ -168,6 +161,7 @@ cea_decoder_608_context *cea_decoder_608_init_library(struct cea_decoder_608_set
 	data->current_color = data->settings->default_color;
 	data->report = settings->report;
 	data->timing = timing;
+	data->log = log;
 
 	clear_eia608_cc_buffer(data, &data->buffer1);
 	clear_eia608_cc_buffer(data, &data->buffer2);
@@ -198,7 +192,7 @@ struct eia608_screen *get_writing_buffer(cea_decoder_608_context *context)
 				use_buffer = &context->buffer2;
 			break;
 		default:
-			fatal(CEA_COMMON_EXIT_BUG_BUG, "Caption mode has an illegal value at get_writing_buffer(), this is a bug.\n");
+			fatal(context->log, CEA_COMMON_EXIT_BUG_BUG, "Caption mode has an illegal value at get_writing_buffer(), this is a bug.\n");
 	}
 	return use_buffer;
 }
@@ -216,8 +210,7 @@ void delete_to_end_of_row(cea_decoder_608_context *context)
 			// TODO: This can change the 'used' situation of a column, so we'd
 			// need to check and correct.
 			use_buffer->characters[context->cursor_row][i] = ' ';
-			use_buffer->colors[context->cursor_row][i] = context->settings->default_color;
-			use_buffer->fonts[context->cursor_row][i] = context->font;
+			use_buffer->styles[context->cursor_row][i] = CEA_608_STYLE(context->settings->default_color, context->font);
 		}
 	}
 }
@@ -235,9 +228,8 @@ void write_char(const unsigned char c, cea_decoder_608_context *context)
 			return;
 
 		use_buffer->characters[context->cursor_row][context->cursor_column] = c;
-		use_buffer->colors[context->cursor_row][context->cursor_column] = context->current_color;
-		use_buffer->fonts[context->cursor_row][context->cursor_column] = context->font;
-		use_buffer->row_used[context->cursor_row] = 1;
+		use_buffer->styles[context->cursor_row][context->cursor_column] = CEA_608_STYLE(context->current_color, context->font);
+		use_buffer->row_used |= CEA_608_ROW_BIT(context->cursor_row);
 
 		if (use_buffer->empty)
 		{
@@ -256,22 +248,21 @@ void write_char(const unsigned char c, cea_decoder_608_context *context)
 	}
 }
 
-/* Handle MID-ROW CODES. */
-void handle_text_attr(const unsigned char c1, const unsigned char c2, cea_decoder_608_context *context)
+/* Handle MID-ROW CODES. i is the pac2_attribs index, 0xFF if the pair
+ * is not a valid mid-row code. */
+void handle_text_attr(const unsigned char c1, const unsigned char c2, unsigned char i, cea_decoder_608_context *context)
 {
 	// Handle channel change
 	context->channel = context->new_channel;
 	if (context->channel != context->my_channel)
 		return;
-	dbg_print(CEA_DMT_DECODER_608, "\r608: text_attr: %02X %02X", c1, c2);
-	if (((c1 != 0x11 && c1 != 0x19) ||
-	     (c2 < 0x20 || c2 > 0x2f)))
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\r608: text_attr: %02X %02X", c1, c2);
+	if (i == 0xFF)
 	{
-		dbg_print(CEA_DMT_DECODER_608, "\rThis is not a text attribute!\n");
+		dbg_print(context->log, CEA_DMT_DECODER_608, "\rThis is not a text attribute!\n");
 	}
 	else
 	{
-		int i = c2 - 0x20;
 		// Mid-row codes put a non-transparent space at the current position with
 		// the OLD attributes, then the new attributes take effect for subsequent
 		// characters.
@@ -283,7 +274,7 @@ void handle_text_attr(const unsigned char c1, const unsigned char c2, cea_decode
 		if (new_font != FONT_ITALICS && new_font != FONT_UNDERLINED_ITALICS)
 			context->current_color = pac2_attribs[i][0];
 		context->font = new_font;
-		dbg_print(
+		dbg_print(context->log,
 		    CEA_DMT_DECODER_608,
 		    "  --  Color: %s,  font: %s\n",
 		    color_text[context->current_color][0],
@@ -301,10 +292,26 @@ struct eia608_screen *get_current_visible_buffer(cea_decoder_608_context *contex
 	return data;
 }
 
-int write_cc_buffer(cea_decoder_608_context *context, struct cc_subtitle *sub)
+/* Append a copy of the screen to the caption ring */
+static struct eia608_screen *push_screen(struct cc_caption_ring *ring, const struct eia608_screen *data,
+					 int64_t start_time, int64_t end_time)
+{
+	struct cc_caption_event *event = cc_ring_push(ring);
+	if (!event)
+		return NULL;
+
+	event->type = CC_608;
+	event->screen = *data;
+	event->screen.start_time = start_time;
+	event->screen.end_time = end_time;
+	event->start_time = start_time;
+	event->end_time = end_time;
+	return &event->screen;
+}
+
+int write_cc_buffer(cea_decoder_608_context *context, struct cc_caption_ring *ring)
 {
 	struct eia608_screen *data;
-	int wrote_something = 0;
 	int64_t start_time;
 	int64_t end_time;
 
@@ -320,7 +327,6 @@ int write_cc_buffer(cea_decoder_608_context *context, struct cc_subtitle *sub)
 
 	start_time = context->current_visible_start_ms;
 	end_time = get_visible_end(context->timing, context->my_field);
-	sub->type = CC_608;
 	data->format = SFORMAT_CC_SCREEN;
 	data->start_time = 0;
 	data->end_time = 0;
@@ -329,80 +335,22 @@ int write_cc_buffer(cea_decoder_608_context *context, struct cc_subtitle *sub)
 	data->my_field = context->my_field;
 	data->my_channel = context->my_channel;
 
-	if (!data->empty)
-	{
-		size_t new_size;
-
-		if ((size_t)sub->nb_data + 1 > SIZE_MAX / sizeof(struct eia608_screen))
-		{
-			mprint("Too many screens, cannot allocate more memory.\n");
-			return 0;
-		}
-
-		new_size = ((size_t)sub->nb_data + 1) * sizeof(struct eia608_screen);
-
-		struct eia608_screen *new_data = (struct eia608_screen *)realloc(sub->data, new_size);
-		if (!new_data)
-		{
-			mprint("Out of memory while reallocating screen buffer\n");
-			return 0;
-		}
-		sub->data = new_data;
-		memcpy(((struct eia608_screen *)sub->data) + sub->nb_data, data, sizeof(*data));
-		sub->nb_data++;
-		wrote_something = 1;
+	if (data->empty)
+		return 0;
 
-		/* Distribute timing across screens that don't have times yet */
-		{
-			int i = 0;
-			int nb_data = sub->nb_data;
-			data = (struct eia608_screen *)sub->data;
-			for (i = 0; (unsigned)i < sub->nb_data; i++)
-			{
-				if (!data->start_time)
-					break;
-				nb_data--;
-				data++;
-			}
-			if (start_time < end_time)
-			{
-				for (i = 0; i < nb_data; i++)
-				{
-					if (context->settings->direct_rollup)
-						data->start_time = start_time;
-					else
-						data->start_time = start_time + (((end_time - start_time) / nb_data) * i);
-					data->end_time = start_time + (((end_time - start_time) / nb_data) * (i + 1));
-					data++;
-				}
-			}
-			else
-			{
-				/* start == end: caption just appeared, end time TBD */
-				for (i = 0; i < nb_data; i++)
-				{
-					data->start_time = start_time;
-					data->end_time = end_time;
-					data++;
-				}
-			}
-		}
-		sub->got_output = 1;
-	}
-	return wrote_something;
+	// When start == end the caption just appeared and its end time is not known yet
+	return push_screen(ring, data, start_time, end_time) != NULL;
 }
-int write_cc_line(cea_decoder_608_context *context, struct cc_subtitle *sub)
+
+int write_cc_line(cea_decoder_608_context *context, struct cc_caption_ring *ring)
 {
 	struct eia608_screen *data;
 	int64_t start_time;
 	int64_t end_time;
-	int i = 0;
-	int wrote_something = 0;
 	data = get_current_visible_buffer(context);
 
 	start_time = context->ts_start_of_current_line;
 	end_time = get_fts(context->timing, context->my_field);
-	sub->type = CC_608;
 	data->format = SFORMAT_CC_LINE;
 	data->start_time = 0;
 	data->end_time = 0;
@@ -411,69 +359,15 @@ int write_cc_line(cea_decoder_608_context *context, struct cc_subtitle *sub)
 	data->my_field = context->my_field;
 	data->my_channel = context->my_channel;
 
-	if (!data->empty)
-	{
-		size_t new_size;
-
-		if ((size_t)sub->nb_data + 1 > SIZE_MAX / sizeof(struct eia608_screen))
-		{
-			mprint("Too many screens, cannot allocate more memory.\n");
-			return 0;
-		}
-
-		new_size = ((size_t)sub->nb_data + 1) * sizeof(struct eia608_screen);
-
-		struct eia608_screen *new_data = (struct eia608_screen *)realloc(sub->data, new_size);
-		if (!new_data)
-		{
-			mprint("Out of memory while reallocating screen buffer\n");
-			return 0;
-		}
-		sub->data = new_data;
-		memcpy(((struct eia608_screen *)sub->data) + sub->nb_data, data, sizeof(*data));
-		data = (struct eia608_screen *)sub->data + sub->nb_data;
-		sub->nb_data++;
+	if (data->empty)
+		return 0;
 
-		for (i = 0; i < CEA_DECODER_608_SCREEN_ROWS; i++)
-		{
-			if (i == context->cursor_row)
-				data->row_used[i] = 1;
-			else
-				data->row_used[i] = 0;
-		}
-		wrote_something = 1;
-		{
-			int nb_data = sub->nb_data;
-			data = (struct eia608_screen *)sub->data;
-			for (i = 0; (unsigned)i < sub->nb_data; i++)
-			{
-				if (!data->start_time)
-					break;
-				nb_data--;
-				data++;
-			}
-			if (start_time < end_time)
-			{
-				for (i = 0; (int)i < nb_data; i++)
-				{
-					data->start_time = start_time + (((end_time - start_time) / nb_data) * i);
-					data->end_time = start_time + (((end_time - start_time) / nb_data) * (i + 1));
-					data++;
-				}
-			}
-			else
-			{
-				for (i = 0; (int)i < nb_data; i++)
-				{
-					data->start_time = start_time;
-					data->end_time = end_time;
-					data++;
-				}
-			}
-		}
-		sub->got_output = 1;
-	}
-	return wrote_something;
+	data = push_screen(ring, data, start_time, end_time);
+	if (!data)
+		return 0;
+	// Only the current line is part of this caption
+	data->row_used = context->cursor_row < CEA_DECODER_608_SCREEN_ROWS ? CEA_608_ROW_BIT(context->cursor_row) : 0;
+	return 1;
 }
 
 // Check if a rollup would cause a line to go off the visible area
@@ -505,12 +399,12 @@ int check_roll_up(cea_decoder_608_context *context)
 			return 0;
 			break;
 	}
-	if (use_buffer->row_used[0]) // If top line is used it will go off the screen no matter what
+	if (use_buffer->row_used & CEA_608_ROW_BIT(0)) // If top line is used it will go off the screen no matter what
 		return 1;
 	int rows_orig = 0; // Number of rows in use right now
 	for (int i = 0; i < CEA_DECODER_608_SCREEN_ROWS; i++)
 	{
-		if (use_buffer->row_used[i])
+		if (use_buffer->row_used & CEA_608_ROW_BIT(i))
 		{
 			rows_orig++;
 			if (firstrow == -1)
@@ -561,7 +455,7 @@ int roll_up(cea_decoder_608_context *context)
 	int rows_orig = 0; // Number of rows in use right now
 	for (int i = 0; i < CEA_DECODER_608_SCREEN_ROWS; i++)
 	{
-		if (use_buffer->row_used[i])
+		if (use_buffer->row_used & CEA_608_ROW_BIT(i))
 		{
 			rows_orig++;
 			if (firstrow == -1)
@@ -570,7 +464,7 @@ int roll_up(cea_decoder_608_context *context)
 		}
 	}
 
-	dbg_print(CEA_DMT_DECODER_608, "\rIn roll-up: %d lines used, first: %d, last: %d\n", rows_orig, firstrow, lastrow);
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rIn roll-up: %d lines used, first: %d, last: %d\n", rows_orig, firstrow, lastrow);
 
 	if (lastrow == -1) // Empty screen, nothing to rollup
 		return 0;
@@ -580,48 +474,26 @@ int roll_up(cea_decoder_608_context *context)
 		if (j >= 0)
 		{
 			memcpy(use_buffer->characters[j], use_buffer->characters[j + 1], CEA_DECODER_608_SCREEN_WIDTH + 1);
+			memcpy(use_buffer->styles[j], use_buffer->styles[j + 1], CEA_DECODER_608_SCREEN_WIDTH + 1);
 
-			for (int i = 0; i < CEA_DECODER_608_SCREEN_WIDTH + 1; ++i)
-			{
-				use_buffer->colors[j][i] = use_buffer->colors[j + 1][i];
-				use_buffer->fonts[j][i] = use_buffer->fonts[j + 1][i];
-			}
-
-			use_buffer->row_used[j] = use_buffer->row_used[j + 1];
+			if (use_buffer->row_used & CEA_608_ROW_BIT(j + 1))
+				use_buffer->row_used |= CEA_608_ROW_BIT(j);
+			else
+				use_buffer->row_used &= ~CEA_608_ROW_BIT(j);
 		}
 	}
 	for (int j = 0; j < (1 + context->cursor_row - keep_lines); j++)
-	{
-		memset(use_buffer->characters[j], ' ', CEA_DECODER_608_SCREEN_WIDTH);
-		use_buffer->characters[j][CEA_DECODER_608_SCREEN_WIDTH] = 0;
+		clear_eia608_row(context, use_buffer, j);
 
-		for (int i = 0; i < CEA_DECODER_608_SCREEN_WIDTH; ++i)
-		{
-			use_buffer->colors[j][i] = context->settings->default_color;
-			use_buffer->fonts[j][i] = FONT_REGULAR;
-		}
-
-		use_buffer->row_used[j] = 0;
-	}
-
-	memset(use_buffer->characters[lastrow], ' ', CEA_DECODER_608_SCREEN_WIDTH);
-	use_buffer->characters[lastrow][CEA_DECODER_608_SCREEN_WIDTH] = 0;
-
-	for (int i = 0; i < CEA_DECODER_608_SCREEN_WIDTH; ++i)
-	{
-		use_buffer->colors[lastrow][i] = context->settings->default_color;
-		use_buffer->fonts[lastrow][i] = FONT_REGULAR;
-	}
-
-	use_buffer->row_used[lastrow] = 0;
+	clear_eia608_row(context, use_buffer, lastrow);
 
 	// Sanity check
 	int rows_now = 0;
 	for (int i = 0; i < CEA_DECODER_608_SCREEN_ROWS; i++)
-		if (use_buffer->row_used[i])
+		if (use_buffer->row_used & CEA_608_ROW_BIT(i))
 			rows_now++;
 	if (rows_now > keep_lines)
-		mprint("Bug in roll_up, should have %d lines but I have %d.\n",
+		mprint(context->log, "Bug in roll_up, should have %d lines but I have %d.\n",
 					   keep_lines, rows_now);
 
 	// If the buffer is now empty, let's set the flag
@@ -668,7 +540,7 @@ int is_current_row_empty(cea_decoder_608_context *context)
 }
 
 /* Process GLOBAL CODES */
-void handle_command(unsigned char c1, const unsigned char c2, cea_decoder_608_context *context, struct cc_subtitle *sub)
+void handle_command(enum command_code command, unsigned char c1, const unsigned char c2, cea_decoder_608_context *context, struct cc_caption_ring *ring)
 {
 	int changes = 0;
 
@@ -677,46 +549,11 @@ void handle_command(unsigned char c1, const unsigned char c2, cea_decoder_608_co
 	if (context->channel != context->my_channel)
 		return;
 
-	enum command_code command = COM_UNKNOWN;
 	if (c1 == 0x15)
 		c1 = 0x14;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x2C)
-		command = COM_ERASEDISPLAYEDMEMORY;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x20)
-		command = COM_RESUMECAPTIONLOADING;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x2F)
-		command = COM_ENDOFCAPTION;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x22)
-		command = COM_ALARMOFF;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x23)
-		command = COM_ALARMON;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x24)
-		command = COM_DELETETOENDOFROW;
-	if ((c1 == 0x17 || c1 == 0x1F) && c2 == 0x21)
-		command = COM_TABOFFSET1;
-	if ((c1 == 0x17 || c1 == 0x1F) && c2 == 0x22)
-		command = COM_TABOFFSET2;
-	if ((c1 == 0x17 || c1 == 0x1F) && c2 == 0x23)
-		command = COM_TABOFFSET3;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x25)
-		command = COM_ROLLUP2;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x26)
-		command = COM_ROLLUP3;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x27)
-		command = COM_ROLLUP4;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x29)
-		command = COM_RESUMEDIRECTCAPTIONING;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x2D)
-		command = COM_CARRIAGERETURN;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x2E)
-		command = COM_ERASENONDISPLAYEDMEMORY;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x21)
-		command = COM_BACKSPACE;
-	if ((c1 == 0x14 || c1 == 0x1C) && c2 == 0x2b)
-		command = COM_RESUMETEXTDISPLAY;
-
-	dbg_print(CEA_DMT_DECODER_608, "\rCommand begin: %02X %02X (%s)\n", c1, c2, command_type[command]);
-	dbg_print(CEA_DMT_DECODER_608, "\rCurrent mode: %d  Position: %d,%d  VisBuf: %d\n", context->mode,
+
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rCommand begin: %02X %02X (%s)\n", c1, c2, command_type[command]);
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rCurrent mode: %d  Position: %d,%d  VisBuf: %d\n", context->mode,
 				     context->cursor_row, context->cursor_column, context->visible_buffer);
 
 	switch (command)
@@ -756,7 +593,7 @@ void handle_command(unsigned char c1, const unsigned char c2, cea_decoder_608_co
 				/* CEA-608 C.10 Style Switching (regulatory)
 				[...]if pop-up or paint-on captioning is already present in
 				either memory it shall be erased[...] */
-				if (write_cc_buffer(context, sub))
+				if (write_cc_buffer(context, ring))
 					context->screenfuls_counter++;
 				erase_memory(context, true);
 				// Track transition from pop-on/paint-on to roll-up for timing adjustment
@@ -820,7 +657,7 @@ void handle_command(unsigned char c1, const unsigned char c2, cea_decoder_608_co
 
 				// Only if the roll up would actually cause a line to disappear we write the buffer
 				{
-					if (write_cc_buffer(context, sub))
+					if (write_cc_buffer(context, ring))
 						context->screenfuls_counter++;
 				}
 			}
@@ -846,7 +683,7 @@ void handle_command(unsigned char c1, const unsigned char c2, cea_decoder_608_co
 		case COM_ERASEDISPLAYEDMEMORY:
 			// Write it to disk before doing this, and make a note of the new
 			// time it became clear.
-			if (write_cc_buffer(context, sub))
+			if (write_cc_buffer(context, ring))
 				context->screenfuls_counter++;
 			erase_memory(context, true);
 			context->current_visible_start_ms = get_visible_start(context->timing, context->my_field);
@@ -854,7 +691,7 @@ void handle_command(unsigned char c1, const unsigned char c2, cea_decoder_608_co
 		case COM_ENDOFCAPTION: // Switch buffers
 			// The currently *visible* buffer is leaving, so now we know its ending
 			// time. Time to actually write it to file.
-			if (write_cc_buffer(context, sub))
+			if (write_cc_buffer(context, ring))
 				context->screenfuls_counter++;
 			context->visible_buffer = (context->visible_buffer == 1) ? 2 : 1;
 			context->current_visible_start_ms = get_visible_start(context->timing, context->my_field);
@@ -877,111 +714,77 @@ void handle_command(unsigned char c1, const unsigned char c2, cea_decoder_608_co
 			// cea_common_logging.log_ftn ("to transcribe to a text file.\n");
 			break;
 		default:
-			dbg_print(CEA_DMT_DECODER_608, "\rNot yet implemented.\n");
+			dbg_print(context->log, CEA_DMT_DECODER_608, "\rNot yet implemented.\n");
 			break;
 	}
-	dbg_print(CEA_DMT_DECODER_608, "\rCurrent mode: %d  Position: %d,%d	VisBuf: %d\n", context->mode,
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rCurrent mode: %d  Position: %d,%d	VisBuf: %d\n", context->mode,
 				     context->cursor_row, context->cursor_column, context->visible_buffer);
-	dbg_print(CEA_DMT_DECODER_608, "\rCommand end: %02X %02X (%s)\n", c1, c2, command_type[command]);
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rCommand end: %02X %02X (%s)\n", c1, c2, command_type[command]);
 }
 
-void flush_608_context(cea_decoder_608_context *context, struct cc_subtitle *sub)
+void flush_608_context(cea_decoder_608_context *context, struct cc_caption_ring *ring)
 {
 	// We issue a EraseDisplayedMemory here so if there's any captions pending
 	// they get written to Subtitle.
-	handle_command(0x14, 0x2c, context, sub); // EDM
+	handle_command(COM_ERASEDISPLAYEDMEMORY, 0x14, 0x2c, context, ring); // EDM
 }
 
 // CEA-608, Anex F 1.1.1. - Character Set Table / Special Characters
-void handle_double(const unsigned char c1, const unsigned char c2, cea_decoder_608_context *context)
+// c is the internal code, 0x80-0x8f
+void handle_double(const unsigned char c1, const unsigned char c2, unsigned char c, cea_decoder_608_context *context)
 {
-	unsigned char c;
 	if (context->channel != context->my_channel)
 		return;
-	if (c2 >= 0x30 && c2 <= 0x3f)
-	{
-		c = c2 + 0x50; // So if c>=0x80 && c<=0x8f, it comes from here
-		dbg_print(CEA_DMT_DECODER_608, "\rDouble: %02X %02X  -->  %c\n", c1, c2, c);
-		write_char(c, context);
-	}
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rDouble: %02X %02X  -->  %c\n", c1, c2, c);
+	write_char(c, context);
 }
 
-/* Process EXTENDED CHARACTERS */
-unsigned char handle_extended(unsigned char hi, unsigned char lo, cea_decoder_608_context *context)
+/* Process EXTENDED CHARACTERS. c is the internal code: 0x90-0xaf for
+ * first byte 0x12, 0xb0-0xcf for 0x13. */
+unsigned char handle_extended(unsigned char hi, unsigned char lo, unsigned char c, cea_decoder_608_context *context)
 {
 	// Handle channel change
 	if (context->new_channel > 2)
 	{
 		context->new_channel -= 2;
-		dbg_print(CEA_DMT_DECODER_608, "\nChannel correction, now %d\n", context->new_channel);
+		dbg_print(context->log, CEA_DMT_DECODER_608, "\nChannel correction, now %d\n", context->new_channel);
 	}
 	context->channel = context->new_channel;
 	if (context->channel != context->my_channel)
 		return 0;
 
-	// For lo values between 0x20-0x3f
-	unsigned char c = 0;
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rExtended: %02X %02X\n", hi, lo);
 
-	dbg_print(CEA_DMT_DECODER_608, "\rExtended: %02X %02X\n", hi, lo);
-	if (lo >= 0x20 && lo <= 0x3f && (hi == 0x12 || hi == 0x13))
-	{
-		switch (hi)
-		{
-			case 0x12:
-				c = lo + 0x70; // So if c>=0x90 && c<=0xaf it comes from here
-				break;
-			case 0x13:
-				c = lo + 0x90; // So if c>=0xb0 && c<=0xcf it comes from here
-				break;
-		}
-		// This column change is because extended characters replace
-		// the previous character (which is sent for basic decoders
-		// to show something similar to the real char)
-		if (context->cursor_column > 0)
-			context->cursor_column--;
+	// This column change is because extended characters replace
+	// the previous character (which is sent for basic decoders
+	// to show something similar to the real char)
+	if (context->cursor_column > 0)
+		context->cursor_column--;
 
-		write_char(c, context);
-	}
+	write_char(c, context);
 	return 1;
 }
 
-/* Process PREAMBLE ACCESS CODES (PAC) */
-void handle_pac(unsigned char c1, unsigned char c2, cea_decoder_608_context *context)
+/* Process PREAMBLE ACCESS CODES (PAC). row and the pac2_attribs index
+ * come from the control code table. */
+void handle_pac(unsigned char c1, unsigned char c2, int row, unsigned char attr, cea_decoder_608_context *context)
 {
 	// Handle channel change
 	if (context->new_channel > 2)
 	{
 		context->new_channel -= 2;
-		dbg_print(CEA_DMT_DECODER_608, "\nChannel correction, now %d\n", context->new_channel);
+		dbg_print(context->log, CEA_DMT_DECODER_608, "\nChannel correction, now %d\n", context->new_channel);
 	}
 	context->channel = context->new_channel;
 	if (context->channel != context->my_channel)
 		return;
 
-	int row = rowdata[((c1 << 1) & 14) | ((c2 >> 5) & 1)];
+	dbg_print(context->log, CEA_DMT_DECODER_608, "\rPAC: %02X %02X", c1, c2);
 
-	dbg_print(CEA_DMT_DECODER_608, "\rPAC: %02X %02X", c1, c2);
-
-	if (c2 >= 0x40 && c2 <= 0x5f)
-	{
-		c2 = c2 - 0x40;
-	}
-	else
-	{
-		if (c2 >= 0x60 && c2 <= 0x7f)
-		{
-			c2 = c2 - 0x60;
-		}
-		else
-		{
-			dbg_print(CEA_DMT_DECODER_608, "\rThis is not a PAC!!!!!\n");
-			return;
-		}
-	}
-	context->current_color = pac2_attribs[c2][0];
-	context->font = pac2_attribs[c2][1];
-	int indent = pac2_attribs[c2][2];
-	dbg_print(CEA_DMT_DECODER_608, "  --  Position: %d:%d, color: %s,  font: %s\n", row,
+	context->current_color = pac2_attribs[attr][0];
+	context->font = pac2_attribs[attr][1];
+	int indent = pac2_attribs[attr][2];
+	dbg_print(context->log, CEA_DMT_DECODER_608, "  --  Position: %d:%d, color: %s,  font: %s\n", row,
 				     indent, color_text[context->current_color][0], font_text[context->font]);
 	if (context->settings->default_color == COL_USERDEFINED && (context->current_color == COL_WHITE || context->current_color == COL_TRANSPARENT))
 		context->current_color = COL_USERDEFINED;
@@ -1003,18 +806,8 @@ void handle_pac(unsigned char c1, unsigned char c2, cea_decoder_608_context *con
 
 		for (int j = row; j < CEA_DECODER_608_SCREEN_ROWS; j++)
 		{
-			if (use_buffer->row_used[j])
-			{
-				memset(use_buffer->characters[j], ' ', CEA_DECODER_608_SCREEN_WIDTH);
-				use_buffer->characters[j][CEA_DECODER_608_SCREEN_WIDTH] = 0;
-
-				for (int i = 0; i < CEA_DECODER_608_SCREEN_WIDTH; ++i)
-				{
-					use_buffer->colors[j][i] = context->settings->default_color;
-					use_buffer->fonts[j][i] = FONT_REGULAR;
-				}
-				use_buffer->row_used[j] = 0;
-			}
+			if (use_buffer->row_used & CEA_608_ROW_BIT(j))
+				clear_eia608_row(context, use_buffer, j);
 		}
 	}
 }
@@ -1023,18 +816,18 @@ void handle_single(const unsigned char c1, cea_decoder_608_context *context)
 {
 	if (c1 < 0x20 || context->channel != context->my_channel)
 		return; // We don't allow special stuff here
-	dbg_print(CEA_DMT_DECODER_608, "%c", c1);
+	dbg_print(context->log, CEA_DMT_DECODER_608, "%c", c1);
 
 	write_char(c1, context);
 }
 
-void erase_both_memories(cea_decoder_608_context *context, struct cc_subtitle *sub)
+void erase_both_memories(cea_decoder_608_context *context, struct cc_caption_ring *ring)
 {
 	erase_memory(context, false);
 	// For the visible memory, we write the contents to disk
 	// The currently *visible* buffer is leaving, so now we know its ending
 	// time. Time to actually write it to file.
-	if (write_cc_buffer(context, sub))
+	if (write_cc_buffer(context, ring))
 		context->screenfuls_counter++;
 	context->current_visible_start_ms = get_visible_start(context->timing, context->my_field);
 	context->cursor_column = 0;
@@ -1045,16 +838,13 @@ void erase_both_memories(cea_decoder_608_context *context, struct cc_subtitle *s
 	erase_memory(context, true);
 }
 
-int check_channel(unsigned char c1, cea_decoder_608_context *context)
+/* channel: the data channel the control code selects, 0 to keep the current one */
+int check_channel(unsigned char channel, cea_decoder_608_context *context)
 {
-	int newchan = context->channel;
-	if (c1 >= 0x10 && c1 <= 0x17)
-		newchan = 1;
-	else if (c1 >= 0x18 && c1 <= 0x1e)
-		newchan = 2;
+	int newchan = channel ? channel : context->channel;
 	if (newchan != context->channel)
 	{
-		dbg_print(CEA_DMT_DECODER_608, "\nChannel change, now %d\n", newchan);
+		dbg_print(context->log, CEA_DMT_DECODER_608, "\nChannel change, now %d\n", newchan);
 		if (context->channel != 3) // Don't delete memories if returning from XDS.
 		{
 			// erase_both_memories (wb); // 47cfr15.119.pdf, page 859, part f
@@ -1066,10 +856,12 @@ int check_channel(unsigned char c1, cea_decoder_608_context *context)
 }
 
 /* Handle Command, special char or attribute and also check for
- * channel changes.
+ * channel changes. The pair is classified with a single lookup in
+ * cea_608_codes.
  * Returns 1 if something was written to screen, 0 otherwise */
-int disCommand(unsigned char hi, unsigned char lo, cea_decoder_608_context *context, struct cc_subtitle *sub)
+int disCommand(unsigned char hi, unsigned char lo, cea_decoder_608_context *context, struct cc_caption_ring *ring)
 {
+	const struct cea_608_code *code = &cea_608_codes[hi - 0x10][lo];
 	int wrote_to_screen = 0;
 
 	/* Full channel changes are only allowed for "GLOBAL CODES",
@@ -1078,85 +870,115 @@ int disCommand(unsigned char hi, unsigned char lo, cea_decoder_608_context *cont
 	 * "PREAMBLE ACCESS CODES", "BACKGROUND COLOR CODES" and
 	 * SPECIAL/SPECIAL CHARACTERS allow only switching
 	 * between 1&3 or 2&4. */
-	context->new_channel = check_channel(hi, context);
-	// if (wb->data608->channel!=cc_channel)
-	//	continue;
+	context->new_channel = check_channel(code->channel, context);
 
-	if (hi >= 0x18 && hi <= 0x1f)
-		hi = hi - 8;
+	// Both data channels share the codes, 8 apart
+	hi &= 0xF7;
 
-	switch (hi)
+	switch (code->action)
 	{
-		case 0x10:
-			if (lo >= 0x40 && lo <= 0x5f)
-				handle_pac(hi, lo, context);
+		case CEA_608_PAC:
+			handle_pac(hi, lo, code->row, code->arg, context);
 			break;
-		case 0x11:
-			if (lo >= 0x20 && lo <= 0x2f)
-				handle_text_attr(hi, lo, context);
-			if (lo >= 0x30 && lo <= 0x3f)
-			{
-				wrote_to_screen = 1;
-				handle_double(hi, lo, context);
-			}
-			if (lo >= 0x40 && lo <= 0x7f)
-				handle_pac(hi, lo, context);
-			break;
-		case 0x12:
-		case 0x13:
-			if (lo >= 0x20 && lo <= 0x3f)
-			{
-				wrote_to_screen = handle_extended(hi, lo, context);
-			}
-			if (lo >= 0x40 && lo <= 0x7f)
-				handle_pac(hi, lo, context);
+		case CEA_608_TEXT_ATTR:
+			handle_text_attr(hi, lo, code->arg, context);
 			break;
-		case 0x14:
-		case 0x15:
-			if (lo >= 0x20 && lo <= 0x2f)
-				handle_command(hi, lo, context, sub);
-			if (lo >= 0x40 && lo <= 0x7f)
-				handle_pac(hi, lo, context);
+		case CEA_608_DOUBLE:
+			wrote_to_screen = 1;
+			handle_double(hi, lo, code->arg, context);
 			break;
-		case 0x16:
-			if (lo >= 0x40 && lo <= 0x7f)
-				handle_pac(hi, lo, context);
+		case CEA_608_EXTENDED:
+			wrote_to_screen = handle_extended(hi, lo, code->arg, context);
 			break;
-		case 0x17:
-			if (lo >= 0x21 && lo <= 0x23)
-				handle_command(hi, lo, context, sub);
-			if (lo >= 0x2e && lo <= 0x2f)
-				handle_text_attr(hi, lo, context);
-			if (lo >= 0x40 && lo <= 0x7f)
-				handle_pac(hi, lo, context);
+		case CEA_608_COMMAND:
+			handle_command((enum command_code)code->arg, hi, lo, context, ring);
 			break;
 	}
 	return wrote_to_screen;
 }
 
-int process608(const unsigned char *data, int length, void *private_data, struct cc_subtitle *sub)
+/* Pick the two channel contexts of the current field. Returns the
+ * field's channel state, or NULL if the field is unknown. */
+static struct cea_608_field_state *field_contexts(struct lib_cc_decode *dec_ctx, int field,
+						  cea_decoder_608_context *ch[2])
+{
+	if (field == 1)
+	{
+		ch[0] = dec_ctx->context_cc608_field_1_ch1;
+		ch[1] = dec_ctx->context_cc608_field_1_ch2;
+	}
+	else if (field == 2)
+	{
+		ch[0] = dec_ctx->context_cc608_field_2_ch1;
+		ch[1] = dec_ctx->context_cc608_field_2_ch2;
+	}
+	else
+		return NULL;
+	return &dec_ctx->field_608[field - 1];
+}
+
+/* Follow the channel selection of one pair and return the channel (1 or 2)
+ * whose context must process it, or 0 if no context needs to see it.
+ * Mirrors what disCommand and the handlers do to context->channel, so
+ * the context receiving the pair can be synced from the field state. */
+static int route_pair(struct cea_608_field_state *field, unsigned char hi, unsigned char lo,
+		      const struct cea_logger *log)
+{
+	if (hi < 0x10 || hi > 0x1F)
+	{
+		// Text, XDS: stays on the current channel
+		field->last_c1 = -1;
+		field->last_c2 = -1;
+		return field->channel;
+	}
+	if (field->last_c1 == hi && field->last_c2 == lo)
+	{
+		// Duplicate dual code, discard. Ignore only the first repetition
+		dbg_print(log, CEA_DMT_DECODER_608, "Skipping command %02X,%02X Duplicate\n", hi, lo);
+		field->last_c1 = -1;
+		field->last_c2 = -1;
+		return 0;
+	}
+	field->last_c1 = hi;
+	field->last_c2 = lo;
+
+	const struct cea_608_code *code = &cea_608_codes[hi - 0x10][lo];
+	field->new_channel = code->channel ? code->channel : field->channel;
+	switch (code->action)
+	{
+		case CEA_608_NONE:
+			return 0;
+		case CEA_608_DOUBLE:
+			// Special characters are written to the current channel
+			return field->channel;
+		default:
+			field->channel = field->new_channel;
+			return field->channel;
+	}
+}
+
+int process608(const unsigned char *data, int length, void *private_data, struct cc_caption_ring *ring)
 {
 	struct cea_decoder_608_report *report = NULL;
 	struct lib_cc_decode *dec_ctx = private_data;
+	struct cea_decoder_608_context *ch[2];
 	struct cea_decoder_608_context *context;
+	struct cea_608_field_state *field;
+	char timebuf[CEA_MSTIME_BUF_SIZE];
 	int i;
 
-	if (dec_ctx->current_field == 1 && dec_ctx->current_channel == 1)
-		context = dec_ctx->context_cc608_field_1_ch1;
-	else if (dec_ctx->current_field == 1 && dec_ctx->current_channel == 2)
-		context = dec_ctx->context_cc608_field_1_ch2;
-	else if (dec_ctx->current_field == 2 && dec_ctx->current_channel == 1)
-		context = dec_ctx->context_cc608_field_2_ch1;
-	else if (dec_ctx->current_field == 2 && dec_ctx->current_channel == 2)
-		context = dec_ctx->context_cc608_field_2_ch2;
-	else
+	field = field_contexts(dec_ctx, dec_ctx->current_field, ch);
+	if (!field)
 		return -1;
-	if (context)
+	for (int c = 0; c < 2; c++)
 	{
-		report = context->report;
-		context->bytes_processed_608 += length;
+		if (ch[c])
+		{
+			report = ch[c]->report;
+			ch[c]->bytes_processed_608 += length;
+		}
 	}
-	if (!data)
+	if (!data || (!ch[0] && !ch[1]))
 	{
 		return -1;
 	}
@@ -1164,6 +986,8 @@ int process608(const unsigned char *data, int length, void *private_data, struct
 	{
 		unsigned char hi, lo;
 		int wrote_to_screen = 0;
+		int prev_channel = field->channel;
+		int target;
 
 		hi = data[i] & 0x7F;	 // Get rid of parity bit
 		lo = data[i + 1] & 0x7F; // Get rid of parity bit
@@ -1175,77 +999,55 @@ int process608(const unsigned char *data, int length, void *private_data, struct
 
 		if (hi >= 0x10 && hi <= 0x1e)
 		{
-			int ch = (hi <= 0x17) ? 1 : 2;
-			if (context == NULL || context->my_field == 2) // Originally: current_field from sequencing.c. Seems to be just to change channel, so context->my_field seems good.
-				ch += 2;
+			int cc = (hi <= 0x17) ? 1 : 2;
+			if (dec_ctx->current_field == 2)
+				cc += 2;
 
 			if (report)
-				report->cc_channels[ch - 1] = 1;
+				report->cc_channels[cc - 1] = 1;
 		}
 
+		// Each pair goes only to the context of the channel it is for
+		target = route_pair(field, hi, lo, dec_ctx->log);
+		if (!target)
+			continue;
+		context = ch[target - 1];
+		if (!context) // Channel disabled
+			continue;
+		context->channel = prev_channel;
+
 		if (hi >= 0x10 && hi <= 0x1F) // Non-character code or special/extended char
 					      // http://www.theneitherworld.com/mcpoodle/SCC_TOOLS/DOCS/CC_CODES.HTML
 					      // http://www.theneitherworld.com/mcpoodle/SCC_TOOLS/DOCS/CC_CHARS.HTML
 		{
-			if (!context)		 // Not XDS and we don't have a writebuffer, nothing else would have an effect
-				continue;
-
 			// We were writing characters before, start a new line for
 			// diagnostic output from disCommand()
 			if (context->textprinted == 1)
 			{
-				dbg_print(CEA_DMT_DECODER_608, "\n");
+				dbg_print(context->log, CEA_DMT_DECODER_608, "\n");
 				context->textprinted = 0;
 			}
 
-			if (context->last_c1 == hi && context->last_c2 == lo)
-			{
-				// Duplicate dual code, discard. Correct to do it only in
-				dbg_print(CEA_DMT_DECODER_608, "Skipping command %02X,%02X Duplicate\n", hi, lo);
-				// Ignore only the first repetition
-				context->last_c1 = -1;
-				context->last_c2 = -1;
-				continue;
-			}
-			context->last_c1 = hi;
-			context->last_c2 = lo;
-			wrote_to_screen = disCommand(hi, lo, context, sub);
-			if (sub->got_output)
-			{
-				i += 2; // Otherwise we wouldn't be counting this byte pair
-				break;
-			}
+			wrote_to_screen = disCommand(hi, lo, context, ring);
 		}
 		else
 		{
-			if (!context) // No XDS code after this point, and user doesn't want captions.
-				continue;
-
-			context->last_c1 = -1;
-			context->last_c2 = -1;
-
 			if (hi >= 0x20) // Standard characters (always in pairs)
 			{
-				// Only print if the channel is active
-				if (context->channel != context->my_channel)
-					continue;
-
 				if (context->textprinted == 0)
 				{
-					dbg_print(CEA_DMT_DECODER_608, "\n");
+					dbg_print(context->log, CEA_DMT_DECODER_608, "\n");
 					context->textprinted = 1;
 				}
 
 				handle_single(hi, context);
 				handle_single(lo, context);
 				wrote_to_screen = 1;
-				context->last_c1 = 0;
-				context->last_c2 = 0;
 			}
 
-			if (!context->textprinted && context->channel == context->my_channel)
+			if (!context->textprinted)
 			{ // Current FTS information after the characters are shown
-				dbg_print(CEA_DMT_DECODER_608, "Current FTS: %s\n", print_mstime_static(get_fts(dec_ctx->timing, context->my_field)));
+				dbg_print(context->log, CEA_DMT_DECODER_608, "Current FTS: %s\n", print_mstime(get_fts(dec_ctx->timing, context->my_field), timebuf));
 				// printf("  N:%u", unsigned(fts_now) );
 				// printf("  G:%u", unsigned(fts_global) );
 				// printf("  F:%d %d %d %d\n",
@@ -1258,7 +1060,7 @@ int process608(const unsigned char *data, int length, void *private_data, struct
 			     context->mode == MODE_ROLLUP_4))
 			{
 				// We don't increase screenfuls_counter here.
-				write_cc_buffer(context, sub);
+				write_cc_buffer(context, ring);
 				context->current_visible_start_ms = get_visible_start(context->timing, context->my_field);
 			}
 		}
@@ -1268,12 +1070,29 @@ int process608(const unsigned char *data, int length, void *private_data, struct
 	return i;
 }
 
-/* Return a pointer to a string that holds the printable characters
- * of the caption data block. FOR DEBUG PURPOSES ONLY! */
-unsigned char *debug_608_to_ASC(unsigned char *cc_data, int channel)
+void flush_608_field(struct lib_cc_decode *dec_ctx, int field, struct cc_caption_ring *ring)
 {
-	static unsigned char output[3];
+	struct cea_decoder_608_context *ch[2];
+	struct cea_608_field_state *state = field_contexts(dec_ctx, field, ch);
+
+	if (!state)
+		return;
+	for (int c = 0; c < 2; c++)
+	{
+		if (!ch[c])
+			continue;
+		// EDM applies to the channel named by the last control code
+		ch[c]->channel = state->channel;
+		ch[c]->new_channel = state->new_channel;
+		flush_608_context(ch[c], ring);
+	}
+	state->channel = state->new_channel;
+}
 
+/* Fill output (3 bytes) with the printable characters of the caption
+ * data block and return it. FOR DEBUG PURPOSES ONLY! */
+unsigned char *debug_608_to_ASC(unsigned char *cc_data, int channel, unsigned char *output)
+{
 	unsigned char cc_valid = (cc_data[0] & 4) >> 2;
 	unsigned char cc_type = cc_data[0] & 3;
 	unsigned char hi, lo;
@@ -41,7 +41,6 @@ typedef struct cea_decoder_608_context
 	int screenfuls_counter;		// Number of meaningful screenfuls written
 	int64_t current_visible_start_ms; // At what time did the current visible buffer became so?
 	enum cc_modes mode;
-	unsigned char last_c1, last_c2;
 	int channel;				       // Currently selected channel
 	enum cea_decoder_608_color_code current_color; // Color we are currently using to write
 	enum font_bits font;			       // Font we are currently using to write
@@ -61,6 +60,7 @@ typedef struct cea_decoder_608_context
 	int64_t subs_delay;		      // ms to delay (or advance) subs
 	int textprinted;
 	struct cea_common_timing_ctx *timing;
+	const struct cea_logger *log;
 
 } cea_decoder_608_context;
 
@@ -89,6 +89,29 @@ enum command_code
 	COM_RESUMEDIRECTCAPTIONING = 17,
 };
 
+/* What a control code pair asks the decoder to do */
+enum cea_608_action
+{
+	CEA_608_NONE = 0,   /* No effect beyond the channel switch */
+	CEA_608_PAC,        /* Preamble address code: arg = pac2_attribs index */
+	CEA_608_TEXT_ATTR,  /* Mid-row code: arg = pac2_attribs index, 0xFF if invalid */
+	CEA_608_DOUBLE,     /* Special character: arg = internal char code */
+	CEA_608_EXTENDED,   /* Extended character: arg = internal char code */
+	CEA_608_COMMAND,    /* Miscellaneous control code: arg = enum command_code */
+};
+
+struct cea_608_code
+{
+	unsigned char action;  /* enum cea_608_action */
+	unsigned char arg;
+	signed char row;       /* PAC only: screen row, 1-15 */
+	unsigned char channel; /* Data channel the first byte selects: 1, 2, or 0 to keep */
+};
+
+/* Classification of every control code pair, indexed by
+ * [first byte - 0x10][second byte], both with parity stripped */
+extern const struct cea_608_code cea_608_codes[16][128];
+
 void cea_decoder_608_dinit_library(void **ctx);
 /*
  *
@@ -96,7 +119,8 @@ void cea_decoder_608_dinit_library(void **ctx);
 cea_decoder_608_context *cea_decoder_608_init_library(struct cea_decoder_608_settings *settings, int channel,
 						      int field, int *halt,
 						      int cc_to_stdout,
-						      struct cea_common_timing_ctx *timing);
+						      struct cea_common_timing_ctx *timing,
+						      const struct cea_logger *log);
 
 /**
  * @param data raw cc608 data to be processed
@@ -106,19 +130,24 @@ cea_decoder_608_context *cea_decoder_608_init_library(struct cea_decoder_608_set
  * @param private_data context of cc608 where important information related to 608
  * 		  are stored.
  *
- * @param sub pointer to subtitle should be memset to 0 when passed first time
- *            subtitle are stored when structure return
+ * @param ring caption ring of the context, completed screens are appended to it
  *
  * @return number of bytes used from data, -1 when any error is encountered
  */
-int process608(const unsigned char *data, int length, void *private_data, struct cc_subtitle *sub);
+int process608(const unsigned char *data, int length, void *private_data, struct cc_caption_ring *ring);
 
 /**
  * Issue a EraseDisplayedMemory here so if there's any captions pending
- * they get written to cc_subtitle
+ * they get written to the caption ring
+ */
+void flush_608_context(cea_decoder_608_context *context, struct cc_caption_ring *ring);
+
+/**
+ * Flush both channel contexts of an EIA-608 field (1 or 2), skipping
+ * disabled ones
  */
-void flush_608_context(cea_decoder_608_context *context, struct cc_subtitle *sub);
+void flush_608_field(struct lib_cc_decode *dec_ctx, int field, struct cc_caption_ring *ring);
 
-int write_cc_buffer(cea_decoder_608_context *context, struct cc_subtitle *sub);
+int write_cc_buffer(cea_decoder_608_context *context, struct cc_caption_ring *ring);
 
 #endif
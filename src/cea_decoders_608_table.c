@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#include "cea_decoders_608.h"
+
+/* ------------------------------------------------------------------ */
+/* EIA-608 control code table.                                          */
+/*                                                                      */
+/* Every entry is a constant expression of its (hi, lo) pair, so the    */
+/* compiler generates the whole table at build time from the rules      */
+/* below. The second channel (0x18-0x1F) uses the same codes as the     */
+/* first, 8 higher.                                                     */
+/* ------------------------------------------------------------------ */
+
+#define IN(x, a, b) ((x) >= (a) && (x) <= (b))
+#define FOLD(hi) ((hi) & 0xF7)
+
+/* Data channel: 0x10-0x17 select channel 1, 0x18-0x1E channel 2, and
+ * 0x1F leaves the current one in place */
+#define CHANNEL(hi) ((hi) <= 0x17 ? 1 : (hi) <= 0x1E ? 2 : 0)
+
+#define ACTION(f, lo)                                                                                          \
+	((f) == 0x10   ? (IN(lo, 0x40, 0x5F) ? CEA_608_PAC : CEA_608_NONE)                                     \
+	 : (f) == 0x11 ? (IN(lo, 0x20, 0x2F)   ? CEA_608_TEXT_ATTR                                             \
+			  : IN(lo, 0x30, 0x3F) ? CEA_608_DOUBLE                                                \
+			  : IN(lo, 0x40, 0x7F) ? CEA_608_PAC                                                   \
+					       : CEA_608_NONE)                                                 \
+	 : (f) <= 0x13 ? (IN(lo, 0x20, 0x3F) ? CEA_608_EXTENDED : IN(lo, 0x40, 0x7F) ? CEA_608_PAC : CEA_608_NONE) \
+	 : (f) <= 0x15 ? (IN(lo, 0x20, 0x2F) ? CEA_608_COMMAND : IN(lo, 0x40, 0x7F) ? CEA_608_PAC : CEA_608_NONE)  \
+	 : (f) == 0x16 ? (IN(lo, 0x40, 0x7F) ? CEA_608_PAC : CEA_608_NONE)                                     \
+		       : (IN(lo, 0x21, 0x23)   ? CEA_608_COMMAND                                               \
+			  : IN(lo, 0x2E, 0x2F) ? CEA_608_TEXT_ATTR                                             \
+			  : IN(lo, 0x40, 0x7F) ? CEA_608_PAC                                                   \
+					       : CEA_608_NONE))
+
+/* Miscellaneous control codes (0x14/0x15 and 0x17 first bytes) */
+#define COMMAND(f, lo)                                  \
+	((f) == 0x17   ? ((lo) == 0x21   ? COM_TABOFFSET1 \
+			  : (lo) == 0x22 ? COM_TABOFFSET2 \
+					 : COM_TABOFFSET3) \
+	 : (lo) == 0x20 ? COM_RESUMECAPTIONLOADING      \
+	 : (lo) == 0x21 ? COM_BACKSPACE                 \
+	 : (lo) == 0x22 ? COM_ALARMOFF                  \
+	 : (lo) == 0x23 ? COM_ALARMON                   \
+	 : (lo) == 0x24 ? COM_DELETETOENDOFROW          \
+	 : (lo) == 0x25 ? COM_ROLLUP2                   \
+	 : (lo) == 0x26 ? COM_ROLLUP3                   \
+	 : (lo) == 0x27 ? COM_ROLLUP4                   \
+	 : (lo) == 0x29 ? COM_RESUMEDIRECTCAPTIONING    \
+	 : (lo) == 0x2B ? COM_RESUMETEXTDISPLAY         \
+	 : (lo) == 0x2C ? COM_ERASEDISPLAYEDMEMORY      \
+	 : (lo) == 0x2D ? COM_CARRIAGERETURN            \
+	 : (lo) == 0x2E ? COM_ERASENONDISPLAYEDMEMORY   \
+	 : (lo) == 0x2F ? COM_ENDOFCAPTION              \
+			: COM_UNKNOWN)
+
+#define ARG(f, lo)                                                                     \
+	(ACTION(f, lo) == CEA_608_PAC	    ? (lo) & 0x1F                               \
+	 : ACTION(f, lo) == CEA_608_TEXT_ATTR ? ((f) == 0x11 ? (lo) - 0x20 : 0xFF)       \
+	 : ACTION(f, lo) == CEA_608_DOUBLE    ? (lo) + 0x50 /* 0x80-0x8f */              \
+	 : ACTION(f, lo) == CEA_608_EXTENDED  ? (lo) + ((f) == 0x12 ? 0x70 : 0x90)       \
+	 : ACTION(f, lo) == CEA_608_COMMAND   ? COMMAND(f, lo)                           \
+					      : 0)
+
+/* PAC row from bits 2-0 of the first byte and bit 5 of the second:
+ * 11, -1, 1, 2, 3, 4, 12, 13, 14, 15, 5, 6, 7, 8, 9, 10 */
+#define ROW_OF(i) ((i) == 0 ? 11 : (i) == 1 ? -1 : (i) < 6 ? (i) - 1 : (i) < 10 ? (i) + 6 : (i) - 5)
+#define ROW(f, lo) (ACTION(f, lo) == CEA_608_PAC ? ROW_OF((((f) << 1) & 14) | (((lo) >> 5) & 1)) : 0)
+
+#define E(hi, lo) {ACTION(FOLD(hi), lo), ARG(FOLD(hi), lo), ROW(FOLD(hi), lo), CHANNEL(hi)}
+#define E8(hi, lo) E(hi, lo), E(hi, lo + 1), E(hi, lo + 2), E(hi, lo + 3), \
+		   E(hi, lo + 4), E(hi, lo + 5), E(hi, lo + 6), E(hi, lo + 7)
+#define E128(hi)                                                        \
+	{                                                               \
+		E8(hi, 0x00), E8(hi, 0x08), E8(hi, 0x10), E8(hi, 0x18), \
+		E8(hi, 0x20), E8(hi, 0x28), E8(hi, 0x30), E8(hi, 0x38), \
+		E8(hi, 0x40), E8(hi, 0x48), E8(hi, 0x50), E8(hi, 0x58), \
+		E8(hi, 0x60), E8(hi, 0x68), E8(hi, 0x70), E8(hi, 0x78)  \
+	}
+
+const struct cea_608_code cea_608_codes[16][128] = {
+	E128(0x10), E128(0x11), E128(0x12), E128(0x13),
+	E128(0x14), E128(0x15), E128(0x16), E128(0x17),
+	E128(0x18), E128(0x19), E128(0x1A), E128(0x1B),
+	E128(0x1C), E128(0x1D), E128(0x1E), E128(0x1F),
+};
@@ -18,6 +18,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 /* Portions by Daniel Kristjansson, extracted from MythTV's source */
 
@@ -210,8 +213,9 @@ void dtvcc_clear_packet(dtvcc_ctx *ctx)
 
 void dtvcc_tv_clear(dtvcc_service_decoder *decoder)
 {
-	for (int i = 0; i < CEA_DTVCC_SCREENGRID_ROWS; i++)
-		memset(decoder->tv->chars[i], 0, CEA_DTVCC_SCREENGRID_COLUMNS * sizeof(dtvcc_symbol));
+	// Pen colors and attributes are kept, as with the full grid before
+	if (decoder->tv->chars)
+		memset(decoder->tv->chars, 0, (size_t)decoder->tv->rows * decoder->tv->cols * sizeof(dtvcc_symbol));
 	decoder->tv->time_ms_show = -1;
 	decoder->tv->time_ms_hide = -1;
 };
@@ -228,10 +232,10 @@ int dtvcc_decoder_has_visible_windows(dtvcc_service_decoder *decoder)
 
 void dtvcc_window_clear_row(dtvcc_window *window, int row_index)
 {
-	if (window->memory_reserved)
+	if (row_index < window->memory_rows)
 	{
-		memset(window->rows[row_index], 0, CEA_DTVCC_MAX_COLUMNS * sizeof(dtvcc_symbol));
-		for (int column_index = 0; column_index < CEA_DTVCC_MAX_COLUMNS; column_index++)
+		memset(window->rows[row_index], 0, window->memory_cols * sizeof(dtvcc_symbol));
+		for (int column_index = 0; column_index < window->memory_cols; column_index++)
 		{
 			window->pen_attribs[row_index][column_index] = dtvcc_default_pen_attribs;
 			window->pen_colors[row_index][column_index] = dtvcc_default_pen_color;
@@ -274,7 +278,7 @@ void dtvcc_window_apply_style(dtvcc_window *window, dtvcc_window_attribs *style)
 
 int dtvcc_is_win_row_empty(dtvcc_window *window, int row_index)
 {
-	for (int j = 0; j < CEA_DTVCC_MAX_COLUMNS; j++)
+	for (int j = 0; j < window->memory_cols; j++)
 	{
 		if (CEA_DTVCC_SYM_IS_SET(window->rows[row_index][j]))
 			return 0;
@@ -284,17 +288,17 @@ int dtvcc_is_win_row_empty(dtvcc_window *window, int row_index)
 
 void dtvcc_get_win_write_interval(dtvcc_window *window, int row_index, int *first, int *last)
 {
-	for (*first = 0; *first < CEA_DTVCC_MAX_COLUMNS; (*first)++)
+	for (*first = 0; *first < window->memory_cols; (*first)++)
 		if (CEA_DTVCC_SYM_IS_SET(window->rows[row_index][*first]))
 			break;
-	for (*last = CEA_DTVCC_MAX_COLUMNS - 1; *last > 0; (*last)--)
+	for (*last = window->memory_cols - 1; *last > 0; (*last)--)
 		if (CEA_DTVCC_SYM_IS_SET(window->rows[row_index][*last]))
 			break;
 }
 
 void dtvcc_window_dump(dtvcc_service_decoder *decoder, dtvcc_window *window)
 {
-	dbg_print(CEA_DMT_GENERIC_NOTICES, "[CEA-708] Window %d dump:\n", window->number);
+	dbg_print(decoder->log, CEA_DMT_GENERIC_NOTICES, "[CEA-708] Window %d dump:\n", window->number);
 
 	if (!window->is_defined)
 		return;
@@ -306,8 +310,8 @@ void dtvcc_window_dump(dtvcc_service_decoder *decoder, dtvcc_window *window)
 	print_mstime_buff(window->time_ms_show, "%02u:%02u:%02u:%03u", tbuf1);
 	print_mstime_buff(window->time_ms_hide, "%02u:%02u:%02u:%03u", tbuf2);
 
-	dbg_print(CEA_DMT_GENERIC_NOTICES, "\r%s --> %s\n", tbuf1, tbuf2);
-	for (int i = 0; i < CEA_DTVCC_MAX_ROWS; i++)
+	dbg_print(decoder->log, CEA_DMT_GENERIC_NOTICES, "\r%s --> %s\n", tbuf1, tbuf2);
+	for (int i = 0; i < window->memory_rows; i++)
 	{
 		if (!dtvcc_is_win_row_empty(window, i))
 		{
@@ -319,13 +323,13 @@ void dtvcc_window_dump(dtvcc_service_decoder *decoder, dtvcc_window *window)
 				sym = window->rows[i][j];
 				int len = utf16_to_utf8(sym.sym, sym_buf);
 				for (int index = 0; index < len; index++)
-					dbg_print(CEA_DMT_GENERIC_NOTICES, "%c", sym_buf[index]);
+					dbg_print(decoder->log, CEA_DMT_GENERIC_NOTICES, "%c", sym_buf[index]);
 			}
-			dbg_print(CEA_DMT_GENERIC_NOTICES, "\n");
+			dbg_print(decoder->log, CEA_DMT_GENERIC_NOTICES, "\n");
 		}
 	}
 
-	dbg_print(CEA_DMT_GENERIC_NOTICES, "[CEA-708] Dump done\n", window->number);
+	dbg_print(decoder->log, CEA_DMT_GENERIC_NOTICES, "[CEA-708] Dump done\n", window->number);
 }
 
 #endif
@@ -340,18 +344,18 @@ void dtvcc_windows_reset(dtvcc_service_decoder *decoder)
 		memset(decoder->windows[j].commands, 0, sizeof(decoder->windows[j].commands));
 	}
 	decoder->current_window = -1;
+	decoder->visible_change_seq++;
 	dtvcc_tv_clear(decoder);
 }
 
 void dtvcc_decoders_reset(dtvcc_ctx *dtvcc)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_decoders_reset: Resetting all decoders\n");
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_decoders_reset: Resetting all decoders\n");
 
-	for (int i = 0; i < CEA_DTVCC_MAX_SERVICES; i++)
+	for (int i = 0; i < dtvcc->active_services_count; i++)
 	{
-		if (!dtvcc->services_active[i])
-			continue;
-		dtvcc_windows_reset(&dtvcc->decoders[i]);
+		if (dtvcc->decoders[i])
+			dtvcc_windows_reset(dtvcc->decoders[i]);
 	}
 
 	dtvcc_clear_packet(dtvcc);
@@ -360,6 +364,175 @@ void dtvcc_decoders_reset(dtvcc_ctx *dtvcc)
 	dtvcc->report->reset_count++;
 }
 
+/* Number of trailing zero bits of a non-zero 64-bit value */
+static int ctz64(uint64_t v)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long idx;
+	_BitScanForward64(&idx, v);
+	return (int)idx;
+#else
+	int n = 0;
+	while (!(v & 1))
+	{
+		v >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+int dtvcc_next_service(uint64_t *mask)
+{
+	int i = ctz64(*mask);
+	*mask &= *mask - 1;
+	return i;
+}
+
+dtvcc_service_decoder *dtvcc_service_decoder_of(const dtvcc_ctx *dtvcc, int service_index)
+{
+	return dtvcc->decoders[dtvcc->service_slot[service_index]];
+}
+
+/* service_index must be active */
+dtvcc_service_decoder *dtvcc_get_service_decoder(dtvcc_ctx *dtvcc, int service_index)
+{
+	dtvcc_service_decoder *decoder = dtvcc_service_decoder_of(dtvcc, service_index);
+	if (decoder)
+		return decoder;
+
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_get_service_decoder: allocating service %d\n",
+		  service_index + 1);
+
+	decoder = (dtvcc_service_decoder *)calloc(1, sizeof(dtvcc_service_decoder));
+	if (!decoder)
+		fatal(dtvcc->log, EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_get_service_decoder");
+	decoder->log = dtvcc->log;
+	decoder->tv = (dtvcc_tv_screen *)calloc(1, sizeof(dtvcc_tv_screen));
+	if (!decoder->tv)
+		fatal(dtvcc->log, EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_get_service_decoder");
+	decoder->tv->service_number = service_index + 1;
+
+	dtvcc_windows_reset(decoder);
+
+	dtvcc->decoders[dtvcc->service_slot[service_index]] = decoder;
+	return decoder;
+}
+
+void dtvcc_service_decoder_free(dtvcc_service_decoder *decoder)
+{
+	if (!decoder)
+		return;
+
+	for (int j = 0; j < CEA_DTVCC_MAX_WINDOWS; j++)
+	{
+		dtvcc_window *window = &decoder->windows[j];
+		for (int k = 0; k < window->memory_rows; k++)
+		{
+			free(window->rows[k]);
+			free(window->pen_colors[k]);
+			free(window->pen_attribs[k]);
+		}
+		window->memory_rows = 0;
+		window->memory_cols = 0;
+	}
+
+	dtvcc_tv_free(decoder->tv);
+	free(decoder);
+}
+
+void dtvcc_tv_free(dtvcc_tv_screen *tv)
+{
+	if (!tv)
+		return;
+	free(tv->chars);
+	free(tv->pen_colors);
+	free(tv->pen_attribs);
+	free(tv);
+}
+
+/* Grow the screen area to cover grid rows top..top+rows-1 and the first
+   cols columns. Cells already on the screen keep their place on the grid,
+   new ones start cleared. */
+static void dtvcc_tv_reserve(dtvcc_service_decoder *decoder, int top, int rows, int cols)
+{
+	dtvcc_tv_screen *tv = decoder->tv;
+	int bottom = top + rows;
+
+	if (tv->chars)
+	{
+		if (top >= tv->top && bottom <= tv->top + tv->rows && cols <= tv->cols)
+			return;
+		top = top < tv->top ? top : tv->top;
+		bottom = bottom > tv->top + tv->rows ? bottom : tv->top + tv->rows;
+		cols = cols > tv->cols ? cols : tv->cols;
+	}
+	rows = bottom - top;
+
+	size_t cells = (size_t)rows * cols;
+	dtvcc_symbol *chars = (dtvcc_symbol *)calloc(cells, sizeof(dtvcc_symbol));
+	dtvcc_pen_color *pen_colors = (dtvcc_pen_color *)calloc(cells, sizeof(dtvcc_pen_color));
+	dtvcc_pen_attribs *pen_attribs = (dtvcc_pen_attribs *)calloc(cells, sizeof(dtvcc_pen_attribs));
+	if (!chars || !pen_colors || !pen_attribs)
+		fatal(decoder->log, EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_tv_reserve");
+
+	for (int i = 0; i < tv->rows; i++)
+	{
+		size_t from = (size_t)i * tv->cols;
+		size_t to = (size_t)(tv->top - top + i) * cols;
+		memcpy(chars + to, tv->chars + from, tv->cols * sizeof(dtvcc_symbol));
+		memcpy(pen_colors + to, tv->pen_colors + from, tv->cols * sizeof(dtvcc_pen_color));
+		memcpy(pen_attribs + to, tv->pen_attribs + from, tv->cols * sizeof(dtvcc_pen_attribs));
+	}
+	free(tv->chars);
+	free(tv->pen_colors);
+	free(tv->pen_attribs);
+	tv->chars = chars;
+	tv->pen_colors = pen_colors;
+	tv->pen_attribs = pen_attribs;
+	tv->top = top;
+	tv->rows = rows;
+	tv->cols = cols;
+}
+
+/* Grow the window's cell storage to at least row_count x col_count. New cells start cleared. */
+void dtvcc_window_reserve(dtvcc_service_decoder *decoder, dtvcc_window *window, int row_count, int col_count)
+{
+	if (col_count > window->memory_cols)
+	{
+		for (int i = 0; i < window->memory_rows; i++)
+		{
+			window->rows[i] = (dtvcc_symbol *)realloc(window->rows[i], col_count * sizeof(dtvcc_symbol));
+			window->pen_colors[i] = (dtvcc_pen_color *)realloc(window->pen_colors[i], col_count * sizeof(dtvcc_pen_color));
+			window->pen_attribs[i] = (dtvcc_pen_attribs *)realloc(window->pen_attribs[i], col_count * sizeof(dtvcc_pen_attribs));
+			if (!window->rows[i] || !window->pen_colors[i] || !window->pen_attribs[i])
+				fatal(decoder->log, EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_window_reserve");
+
+			memset(window->rows[i] + window->memory_cols, 0, (col_count - window->memory_cols) * sizeof(dtvcc_symbol));
+			for (int j = window->memory_cols; j < col_count; j++)
+			{
+				window->pen_attribs[i][j] = dtvcc_default_pen_attribs;
+				window->pen_colors[i][j] = dtvcc_default_pen_color;
+			}
+		}
+		window->memory_cols = col_count;
+	}
+
+	while (window->memory_rows < row_count)
+	{
+		int i = window->memory_rows;
+		window->rows[i] = (dtvcc_symbol *)malloc(window->memory_cols * sizeof(dtvcc_symbol));
+		window->pen_colors[i] = (dtvcc_pen_color *)malloc(window->memory_cols * sizeof(dtvcc_pen_color));
+		window->pen_attribs[i] = (dtvcc_pen_attribs *)malloc(window->memory_cols * sizeof(dtvcc_pen_attribs));
+		if (!window->rows[i] || !window->pen_colors[i] || !window->pen_attribs[i])
+			fatal(decoder->log, EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_window_reserve");
+		window->memory_rows++;
+		dtvcc_window_clear_row(window, i);
+	}
+}
+
 int dtvcc_compare_win_priorities(const void *a, const void *b)
 {
 	dtvcc_window *w1 = *(dtvcc_window **)a;
@@ -372,7 +545,7 @@ void dtvcc_window_update_time_show(dtvcc_window *window, struct cea_common_timin
 	char buf[128];
 	window->time_ms_show = get_visible_start(timing, 3);
 	print_mstime_buff(window->time_ms_show, "%02u:%02u:%02u:%03u", buf);
-	dbg_print(CEA_DMT_708, "[CEA-708] "
+	dbg_print(timing->log, CEA_DMT_708, "[CEA-708] "
 						  "[W-%d] show time updated to %s\n",
 				     window->number, buf);
 }
@@ -382,17 +555,18 @@ void dtvcc_window_update_time_hide(dtvcc_window *window, struct cea_common_timin
 	char buf[128];
 	window->time_ms_hide = get_visible_end(timing, 3);
 	print_mstime_buff(window->time_ms_hide, "%02u:%02u:%02u:%03u", buf);
-	dbg_print(CEA_DMT_708, "[CEA-708] "
+	dbg_print(timing->log, CEA_DMT_708, "[CEA-708] "
 						  "[W-%d] hide time updated to %s\n",
 				     window->number, buf);
 }
 
-void dtvcc_screen_update_time_show(dtvcc_tv_screen *tv, int64_t time)
+void dtvcc_screen_update_time_show(dtvcc_service_decoder *decoder, int64_t time)
 {
+	dtvcc_tv_screen *tv = decoder->tv;
 	char buf1[128], buf2[128];
 	print_mstime_buff(tv->time_ms_show, "%02u:%02u:%02u:%03u", buf1);
 	print_mstime_buff(time, "%02u:%02u:%02u:%03u", buf2);
-	dbg_print(CEA_DMT_708, "[CEA-708] "
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] "
 						  "Screen show time: %s -> %s\n",
 				     buf1, buf2);
 
@@ -402,12 +576,13 @@ void dtvcc_screen_update_time_show(dtvcc_tv_screen *tv, int64_t time)
 		tv->time_ms_show = time;
 }
 
-void dtvcc_screen_update_time_hide(dtvcc_tv_screen *tv, int64_t time)
+void dtvcc_screen_update_time_hide(dtvcc_service_decoder *decoder, int64_t time)
 {
+	dtvcc_tv_screen *tv = decoder->tv;
 	char buf1[128], buf2[128];
 	print_mstime_buff(tv->time_ms_hide, "%02u:%02u:%02u:%03u", buf1);
 	print_mstime_buff(time, "%02u:%02u:%02u:%03u", buf2);
-	dbg_print(CEA_DMT_708, "[CEA-708] "
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] "
 						  "Screen hide time: %s -> %s\n",
 				     buf1, buf2);
 
@@ -530,14 +705,14 @@ void dtvcc_window_copy_to_screen(dtvcc_service_decoder *decoder, dtvcc_window *w
 	switch (dtvcc_is_window_overlapping(decoder, window))
 	{
 		case OVERLAPPING_WITH_HIGH_PRIORITY:
-			dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_window_copy_to_screen : no handling required \n");
+			dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_window_copy_to_screen : no handling required \n");
 			break;
 		case OVERLAPPED_BY_HIGH_PRIORITY:
-			dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_window_copy_to_screen : window needs to be skipped \n");
+			dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_window_copy_to_screen : window needs to be skipped \n");
 			return;
 	}
 
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_window_copy_to_screen: W-%d\n", window->number);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_window_copy_to_screen: W-%d\n", window->number);
 	int top, left;
 	// For each window we calculate the top, left position depending on the
 	// anchor
@@ -583,11 +758,11 @@ void dtvcc_window_copy_to_screen(dtvcc_service_decoder *decoder, dtvcc_window *w
 			return;
 			break;
 	}
-	dbg_print(CEA_DMT_708, "[CEA-708] For window %d: Anchor point -> %d, size %d:%d, real position %d:%d\n",
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] For window %d: Anchor point -> %d, size %d:%d, real position %d:%d\n",
 				     window->number, window->anchor_point, window->row_count, window->col_count,
 				     top, left);
 
-	dbg_print(
+	dbg_print(decoder->log,
 	    CEA_DMT_708, "[CEA-708] we have top [%d] and left [%d]\n", top, left);
 
 	top = top < 0 ? 0 : top;
@@ -596,21 +771,25 @@ void dtvcc_window_copy_to_screen(dtvcc_service_decoder *decoder, dtvcc_window *w
 	int copyrows = top + window->row_count >= CEA_DTVCC_SCREENGRID_ROWS ? CEA_DTVCC_SCREENGRID_ROWS - top : window->row_count;
 	int copycols = left + window->col_count >= CEA_DTVCC_SCREENGRID_COLUMNS ? CEA_DTVCC_SCREENGRID_COLUMNS - left : window->col_count;
 
-	dbg_print(
+	dbg_print(decoder->log,
 	    CEA_DMT_708, "[CEA-708] %d*%d will be copied to the TV.\n", copyrows, copycols);
 
-	for (int j = 0; j < copyrows; j++)
+	if (copyrows > 0 && copycols > 0)
 	{
-		memcpy(decoder->tv->chars[top + j], window->rows[j], copycols * sizeof(dtvcc_symbol));
-		for (int col = 0; col < CEA_DTVCC_SCREENGRID_COLUMNS; col++)
+		dtvcc_tv_screen *tv = decoder->tv;
+		// Rows are copied from the first grid column, whatever the window's left edge
+		dtvcc_tv_reserve(decoder, top, copyrows, copycols);
+		for (int j = 0; j < copyrows; j++)
 		{
-			decoder->tv->pen_attribs[top + j][col] = window->pen_attribs[j][col];
-			decoder->tv->pen_colors[top + j][col] = window->pen_colors[j][col];
+			size_t cell = (size_t)(top - tv->top + j) * tv->cols;
+			memcpy(tv->chars + cell, window->rows[j], copycols * sizeof(dtvcc_symbol));
+			memcpy(tv->pen_attribs + cell, window->pen_attribs[j], copycols * sizeof(dtvcc_pen_attribs));
+			memcpy(tv->pen_colors + cell, window->pen_colors[j], copycols * sizeof(dtvcc_pen_color));
 		}
 	}
 
-	dtvcc_screen_update_time_show(decoder->tv, window->time_ms_show);
-	dtvcc_screen_update_time_hide(decoder->tv, window->time_ms_hide);
+	dtvcc_screen_update_time_show(decoder, window->time_ms_show);
+	dtvcc_screen_update_time_hide(decoder, window->time_ms_hide);
 
 #ifdef DTVCC_PRINT_DEBUG
 	dtvcc_window_dump(decoder, window);
@@ -619,17 +798,17 @@ void dtvcc_window_copy_to_screen(dtvcc_service_decoder *decoder, dtvcc_window *w
 
 void dtvcc_screen_print(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_screen_print\n");
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_screen_print\n");
 
-	dtvcc_screen_update_time_hide(decoder->tv, get_visible_end(dtvcc->timing, 3));
+	dtvcc_screen_update_time_hide(decoder, get_visible_end(dtvcc->timing, 3));
 
 	decoder->cc_count++;
 	decoder->tv->cc_count++;
 
-	/* Output to cc_subtitle instead of encoder */
-	if (dtvcc->current_sub)
+	/* Output to the caption ring instead of an encoder */
+	if (dtvcc->ring)
 	{
-		dtvcc_screen_to_subtitle(decoder->tv, dtvcc->current_sub);
+		dtvcc_screen_to_subtitle(decoder->tv, dtvcc->ring);
 	}
 
 	dtvcc_tv_clear(decoder);
@@ -638,7 +817,7 @@ void dtvcc_screen_print(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 /* C implementation of dtvcc_decoder_flush (was Rust-only) */
 void dtvcc_decoder_flush(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_decoder_flush\n");
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_decoder_flush\n");
 
 	if (!dtvcc->timing)
 		return;
@@ -663,11 +842,47 @@ void dtvcc_decoder_flush(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 	}
 }
 
+/* Compose the visible windows of a decoder and render their text for live
+   output. The text lives in a buffer owned by the context and is only valid
+   until the next call. Returns NULL if nothing is visible.
+   The decoder's own screen may hold hidden windows waiting to be printed,
+   so the windows are composed on a scratch screen instead. */
+const char *dtvcc_visible_text(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder, int64_t *time_ms_show, int *bottom_row)
+{
+	if (!dtvcc_decoder_has_visible_windows(decoder))
+		return NULL;
+
+	if (!dtvcc->live_tv)
+	{
+		dtvcc->live_tv = (dtvcc_tv_screen *)calloc(1, sizeof(dtvcc_tv_screen));
+		if (!dtvcc->live_tv)
+		{
+			mprint(dtvcc->log, "[CEA-708] dtvcc_visible_text: out of memory\n");
+			return NULL;
+		}
+	}
+
+	dtvcc_tv_screen *tv = decoder->tv;
+	decoder->tv = dtvcc->live_tv;
+	dtvcc_tv_clear(decoder);
+	decoder->tv->service_number = tv->service_number;
+	for (int i = 0; i < CEA_DTVCC_MAX_WINDOWS; i++)
+	{
+		dtvcc_window *window = &decoder->windows[i];
+		if (window->is_defined && window->visible && !window->is_empty)
+			dtvcc_window_copy_to_screen(decoder, window);
+	}
+	decoder->tv = tv;
+
+	*time_ms_show = dtvcc->live_tv->time_ms_show;
+	return dtvcc_screen_to_text(dtvcc->live_tv, &dtvcc->live_text, &dtvcc->live_text_size, bottom_row);
+}
+
 void dtvcc_process_hcr(dtvcc_service_decoder *decoder)
 {
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_process_hcr: Window has to be defined first\n");
+		mprint(decoder->log, "[CEA-708] dtvcc_process_hcr: Window has to be defined first\n");
 		return;
 	}
 
@@ -680,7 +895,7 @@ void dtvcc_process_ff(dtvcc_service_decoder *decoder)
 {
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_process_ff: Window has to be defined first\n");
+		mprint(decoder->log, "[CEA-708] dtvcc_process_ff: Window has to be defined first\n");
 		return;
 	}
 	dtvcc_window *window = &decoder->windows[decoder->current_window];
@@ -700,7 +915,7 @@ void dtvcc_process_bs(dtvcc_service_decoder *decoder)
 {
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_process_bs: Window has to be defined first\n");
+		mprint(decoder->log, "[CEA-708] dtvcc_process_bs: Window has to be defined first\n");
 		return;
 	}
 
@@ -728,7 +943,7 @@ void dtvcc_process_bs(dtvcc_service_decoder *decoder)
 				window->pen_row--;
 			break;
 		default:
-			mprint("[CEA-708] dtvcc_process_character: unhandled branch (%02d)\n",
+			mprint(decoder->log, "[CEA-708] dtvcc_process_character: unhandled branch (%02d)\n",
 						   window->attribs.print_direction);
 			break;
 	}
@@ -738,12 +953,9 @@ void dtvcc_window_rollup(dtvcc_service_decoder *decoder, dtvcc_window *window)
 {
 	for (int i = 0; i < window->row_count - 1; i++)
 	{
-		memcpy(window->rows[i], window->rows[i + 1], CEA_DTVCC_MAX_COLUMNS * sizeof(dtvcc_symbol));
-		for (int z = 0; z < CEA_DTVCC_MAX_COLUMNS; z++)
-		{
-			window->pen_colors[i][z] = window->pen_colors[i + 1][z];
-			window->pen_attribs[i][z] = window->pen_attribs[i + 1][z];
-		}
+		memcpy(window->rows[i], window->rows[i + 1], window->memory_cols * sizeof(dtvcc_symbol));
+		memcpy(window->pen_colors[i], window->pen_colors[i + 1], window->memory_cols * sizeof(dtvcc_pen_color));
+		memcpy(window->pen_attribs[i], window->pen_attribs[i + 1], window->memory_cols * sizeof(dtvcc_pen_attribs));
 	}
 
 	dtvcc_window_clear_row(window, window->row_count - 1);
@@ -753,7 +965,7 @@ void dtvcc_process_cr(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 {
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_process_cr: Window has to be defined first\n");
+		mprint(dtvcc->log, "[CEA-708] dtvcc_process_cr: Window has to be defined first\n");
 		return;
 	}
 
@@ -770,7 +982,7 @@ void dtvcc_process_cr(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 				rollup_required = 1;
 			break;
 		case DTVCC_WINDOW_PD_RIGHT_LEFT:
-			window->pen_column = window->col_count;
+			window->pen_column = window->col_count - 1;
 			if (window->pen_row + 1 < window->row_count)
 				window->pen_row++;
 			else
@@ -784,14 +996,14 @@ void dtvcc_process_cr(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 				rollup_required = 1;
 			break;
 		case DTVCC_WINDOW_PD_BOTTOM_TOP:
-			window->pen_row = window->row_count;
+			window->pen_row = window->row_count - 1;
 			if (window->pen_column + 1 < window->col_count)
 				window->pen_column++;
 			else
 				rollup_required = 1;
 			break;
 		default:
-			mprint("[CEA-708] dtvcc_process_cr: unhandled branch\n");
+			mprint(dtvcc->log, "[CEA-708] dtvcc_process_cr: unhandled branch\n");
 			break;
 	}
 
@@ -800,22 +1012,24 @@ void dtvcc_process_cr(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder)
 		dtvcc_window_update_time_hide(window, dtvcc->timing);
 		if (rollup_required)
 		{
-			dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_cr: rolling up\n");
+			dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_cr: rolling up\n");
 			dtvcc_window_copy_to_screen(decoder, window);
 			dtvcc_screen_print(dtvcc, decoder);
 			dtvcc_window_rollup(decoder, window);
 		}
 		dtvcc_window_update_time_show(window, dtvcc->timing);
+		if (window->visible)
+			decoder->visible_change_seq++;
 	}
 }
 
 void dtvcc_process_character(dtvcc_service_decoder *decoder, dtvcc_symbol symbol)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] %d\n", decoder->current_window);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] %d\n", decoder->current_window);
 	int cw = decoder->current_window;
 	dtvcc_window *window = &decoder->windows[cw];
 
-	dbg_print(
+	dbg_print(decoder->log,
 	    CEA_DMT_708, "[CEA-708] dtvcc_process_character: "
 			 "%c [%02X]  - Window: %d %s, Pen: %d:%d\n",
 	    CEA_DTVCC_SYM(symbol), CEA_DTVCC_SYM(symbol),
@@ -829,6 +1043,8 @@ void dtvcc_process_character(dtvcc_service_decoder *decoder, dtvcc_symbol symbol
 	window->rows[window->pen_row][window->pen_column] = symbol;
 	window->pen_attribs[window->pen_row][window->pen_column] = window->pen_attribs_pattern; // "Painting" char by pen - attribs
 	window->pen_colors[window->pen_row][window->pen_column] = window->pen_color_pattern;	// "Painting" char by pen - colors
+	if (window->visible)
+		decoder->visible_change_seq++;
 	switch (window->attribs.print_direction)
 	{
 		case DTVCC_WINDOW_PD_LEFT_RIGHT:
@@ -848,7 +1064,7 @@ void dtvcc_process_character(dtvcc_service_decoder *decoder, dtvcc_symbol symbol
 				window->pen_row--;
 			break;
 		default:
-			mprint("[CEA-708] dtvcc_process_character: unhandled branch (%02d)\n",
+			mprint(decoder->log, "[CEA-708] dtvcc_process_character: unhandled branch (%02d)\n",
 						   window->attribs.print_direction);
 			break;
 	}
@@ -858,23 +1074,23 @@ void dtvcc_process_character(dtvcc_service_decoder *decoder, dtvcc_symbol symbol
 
 void dtvcc_handle_CWx_SetCurrentWindow(dtvcc_service_decoder *decoder, int window_id)
 {
-	dbg_print(
+	dbg_print(decoder->log,
 	    CEA_DMT_708, "[CEA-708] dtvcc_handle_CWx_SetCurrentWindow: [%d]\n", window_id);
 	if (decoder->windows[window_id].is_defined)
 		decoder->current_window = window_id;
 	else
-		mprint("[CEA-708] dtvcc_handle_CWx_SetCurrentWindow: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_CWx_SetCurrentWindow: "
 					   "window [%d] is not defined\n",
 					   window_id);
 }
 
 void dtvcc_handle_CLW_ClearWindows(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder, int windows_bitmap)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_CLW_ClearWindows: windows: ");
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_CLW_ClearWindows: windows: ");
 	int screen_content_changed = 0,
 	    window_had_content;
 	if (windows_bitmap == 0)
-		dbg_print(CEA_DMT_708, "none\n");
+		dbg_print(dtvcc->log, CEA_DMT_708, "none\n");
 	else
 	{
 		for (int i = 0; i < CEA_DTVCC_MAX_WINDOWS; i++)
@@ -882,50 +1098,52 @@ void dtvcc_handle_CLW_ClearWindows(dtvcc_ctx *dtvcc, dtvcc_service_decoder *deco
 			if (windows_bitmap & 1)
 			{
 				dtvcc_window *window = &decoder->windows[i];
-				dbg_print(CEA_DMT_708, "[W%d] ", i);
+				dbg_print(dtvcc->log, CEA_DMT_708, "[W%d] ", i);
 				window_had_content = window->is_defined && window->visible && !window->is_empty;
 				if (window_had_content)
 				{
 					screen_content_changed = 1;
 					dtvcc_window_update_time_hide(&decoder->windows[i], dtvcc->timing);
 					dtvcc_window_copy_to_screen(decoder, &decoder->windows[i]);
+					decoder->visible_change_seq++;
 				}
 				dtvcc_window_clear(decoder, i);
 			}
 			windows_bitmap >>= 1;
 		}
 	}
-	dbg_print(CEA_DMT_708, "\n");
+	dbg_print(dtvcc->log, CEA_DMT_708, "\n");
 	if (screen_content_changed)
 		dtvcc_screen_print(dtvcc, decoder);
 }
 
 void dtvcc_handle_DSW_DisplayWindows(dtvcc_service_decoder *decoder, int windows_bitmap, struct cea_common_timing_ctx *timing)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_DSW_DisplayWindows: windows: ");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_DSW_DisplayWindows: windows: ");
 	if (windows_bitmap == 0)
-		dbg_print(CEA_DMT_708, "none\n");
+		dbg_print(decoder->log, CEA_DMT_708, "none\n");
 	else
 	{
 		for (int i = 0; i < CEA_DTVCC_MAX_WINDOWS; i++)
 		{
 			if (windows_bitmap & 1)
 			{
-				dbg_print(CEA_DMT_708, "[Window %d] ", i);
+				dbg_print(decoder->log, CEA_DMT_708, "[Window %d] ", i);
 				if (!decoder->windows[i].is_defined)
 				{
-					dbg_print(CEA_DMT_708, "[CEA-708] window %d was not defined\n", i);
+					dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] window %d was not defined\n", i);
 					continue;
 				}
 				if (!decoder->windows[i].visible)
 				{
 					decoder->windows[i].visible = 1;
 					dtvcc_window_update_time_show(&decoder->windows[i], timing);
+					decoder->visible_change_seq++;
 				}
 			}
 			windows_bitmap >>= 1;
 		}
-		dbg_print(CEA_DMT_708, "\n");
+		dbg_print(decoder->log, CEA_DMT_708, "\n");
 	}
 }
 
@@ -933,9 +1151,9 @@ void dtvcc_handle_HDW_HideWindows(dtvcc_ctx *dtvcc,
 				  dtvcc_service_decoder *decoder,
 				  int windows_bitmap)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_HDW_HideWindows: windows: ");
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_HDW_HideWindows: windows: ");
 	if (windows_bitmap == 0)
-		dbg_print(CEA_DMT_708, "none\n");
+		dbg_print(dtvcc->log, CEA_DMT_708, "none\n");
 	else
 	{
 		int screen_content_changed = 0;
@@ -943,11 +1161,12 @@ void dtvcc_handle_HDW_HideWindows(dtvcc_ctx *dtvcc,
 		{
 			if (windows_bitmap & 1)
 			{
-				dbg_print(CEA_DMT_708, "[Window %d] ", i);
+				dbg_print(dtvcc->log, CEA_DMT_708, "[Window %d] ", i);
 				if (decoder->windows[i].visible)
 				{
 					screen_content_changed = 1;
 					decoder->windows[i].visible = 0;
+					decoder->visible_change_seq++;
 					dtvcc_window_update_time_hide(&decoder->windows[i], dtvcc->timing);
 					if (!decoder->windows[i].is_empty)
 						dtvcc_window_copy_to_screen(decoder, &decoder->windows[i]);
@@ -955,7 +1174,7 @@ void dtvcc_handle_HDW_HideWindows(dtvcc_ctx *dtvcc,
 			}
 			windows_bitmap >>= 1;
 		}
-		dbg_print(CEA_DMT_708, "\n");
+		dbg_print(dtvcc->log, CEA_DMT_708, "\n");
 		if (screen_content_changed && !dtvcc_decoder_has_visible_windows(decoder))
 			dtvcc_screen_print(dtvcc, decoder);
 	}
@@ -965,9 +1184,9 @@ void dtvcc_handle_TGW_ToggleWindows(dtvcc_ctx *dtvcc,
 				    dtvcc_service_decoder *decoder,
 				    int windows_bitmap)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_TGW_ToggleWindows: windows: ");
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_TGW_ToggleWindows: windows: ");
 	if (windows_bitmap == 0)
-		dbg_print(CEA_DMT_708, "none\n");
+		dbg_print(dtvcc->log, CEA_DMT_708, "none\n");
 	else
 	{
 		int screen_content_changed = 0;
@@ -976,8 +1195,9 @@ void dtvcc_handle_TGW_ToggleWindows(dtvcc_ctx *dtvcc,
 			dtvcc_window *window = &decoder->windows[i];
 			if ((windows_bitmap & 1) && window->is_defined)
 			{
-				dbg_print(CEA_DMT_708, "[W-%d: %d->%d]", i, window->visible, !window->visible);
+				dbg_print(dtvcc->log, CEA_DMT_708, "[W-%d: %d->%d]", i, window->visible, !window->visible);
 				window->visible = !window->visible;
+				decoder->visible_change_seq++;
 				if (window->visible)
 					dtvcc_window_update_time_show(window, dtvcc->timing);
 				else
@@ -992,7 +1212,7 @@ void dtvcc_handle_TGW_ToggleWindows(dtvcc_ctx *dtvcc,
 			}
 			windows_bitmap >>= 1;
 		}
-		dbg_print(CEA_DMT_708, "\n");
+		dbg_print(dtvcc->log, CEA_DMT_708, "\n");
 		if (screen_content_changed && !dtvcc_decoder_has_visible_windows(decoder))
 			dtvcc_screen_print(dtvcc, decoder);
 	}
@@ -1000,7 +1220,7 @@ void dtvcc_handle_TGW_ToggleWindows(dtvcc_ctx *dtvcc,
 
 void dtvcc_handle_DFx_DefineWindow(dtvcc_service_decoder *decoder, int window_id, unsigned char *data, struct cea_common_timing_ctx *timing)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_DFx_DefineWindow: "
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_DFx_DefineWindow: "
 						  "W[%d], attributes: \n",
 				     window_id);
 
@@ -1011,7 +1231,7 @@ void dtvcc_handle_DFx_DefineWindow(dtvcc_service_decoder *decoder, int window_id
 		// When a decoder receives a DefineWindow command for an existing window, the
 		// command is to be ignored if the command parameters are unchanged from the
 		// previous window definition.
-		dbg_print(
+		dbg_print(decoder->log,
 		    CEA_DMT_708, "[CEA-708] dtvcc_handle_DFx_DefineWindow: Repeated window definition, ignored\n");
 		return;
 	}
@@ -1031,7 +1251,7 @@ void dtvcc_handle_DFx_DefineWindow(dtvcc_service_decoder *decoder, int window_id
 
 	if (row_count > CEA_DTVCC_MAX_ROWS || col_count > CEA_DTVCC_MAX_COLUMNS)
 	{
-		mprint("[CEA-708] Invalid window size %dx%d (max %dx%d), rejecting window definition\n",
+		mprint(decoder->log, "[CEA-708] Invalid window size %dx%d (max %dx%d), rejecting window definition\n",
 					   row_count, col_count, CEA_DTVCC_MAX_ROWS, CEA_DTVCC_MAX_COLUMNS);
 		return;
 	}
@@ -1041,18 +1261,20 @@ void dtvcc_handle_DFx_DefineWindow(dtvcc_service_decoder *decoder, int window_id
 
 	int do_clear_window = 0;
 
-	dbg_print(CEA_DMT_708, "[CEA-708] Visible: [%s]\n", visible ? "Yes" : "No");
-	dbg_print(CEA_DMT_708, "[CEA-708] Priority: [%d]\n", priority);
-	dbg_print(CEA_DMT_708, "[CEA-708] Row count: [%d]\n", row_count);
-	dbg_print(CEA_DMT_708, "[CEA-708] Column count: [%d]\n", col_count);
-	dbg_print(CEA_DMT_708, "[CEA-708] Anchor point: [%d]\n", anchor_point);
-	dbg_print(CEA_DMT_708, "[CEA-708] Anchor vertical: [%d]\n", anchor_vertical);
-	dbg_print(CEA_DMT_708, "[CEA-708] Anchor horizontal: [%d]\n", anchor_horizontal);
-	dbg_print(CEA_DMT_708, "[CEA-708] Relative pos: [%s]\n", relative_pos ? "Yes" : "No");
-	dbg_print(CEA_DMT_708, "[CEA-708] Row lock: [%s]\n", row_lock ? "Yes" : "No");
-	dbg_print(CEA_DMT_708, "[CEA-708] Column lock: [%s]\n", col_lock ? "Yes" : "No");
-	dbg_print(CEA_DMT_708, "[CEA-708] Pen style: [%d]\n", pen_style);
-	dbg_print(CEA_DMT_708, "[CEA-708] Win style: [%d]\n", win_style);
+	dtvcc_window_reserve(decoder, window, row_count, col_count);
+
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Visible: [%s]\n", visible ? "Yes" : "No");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Priority: [%d]\n", priority);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Row count: [%d]\n", row_count);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Column count: [%d]\n", col_count);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Anchor point: [%d]\n", anchor_point);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Anchor vertical: [%d]\n", anchor_vertical);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Anchor horizontal: [%d]\n", anchor_horizontal);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Relative pos: [%s]\n", relative_pos ? "Yes" : "No");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Row lock: [%s]\n", row_lock ? "Yes" : "No");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Column lock: [%s]\n", col_lock ? "Yes" : "No");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Pen style: [%d]\n", pen_style);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] Win style: [%d]\n", win_style);
 
 	/**
 	 * Korean samples have "anchor_vertical" and "anchor_horizontal" mixed up,
@@ -1130,16 +1352,6 @@ void dtvcc_handle_DFx_DefineWindow(dtvcc_service_decoder *decoder, int window_id
 		// are set to the fill color and the pen location is set to (0,0)
 		window->pen_column = 0;
 		window->pen_row = 0;
-		if (!window->memory_reserved)
-		{
-			for (int i = 0; i < CEA_DTVCC_MAX_ROWS; i++)
-			{
-				window->rows[i] = (dtvcc_symbol *)malloc(CEA_DTVCC_MAX_COLUMNS * sizeof(dtvcc_symbol));
-				if (!window->rows[i])
-					fatal(EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_handle_DFx_DefineWindow");
-			}
-			window->memory_reserved = 1;
-		}
 		window->is_defined = 1;
 		dtvcc_window_clear_text(window);
 
@@ -1154,7 +1366,7 @@ void dtvcc_handle_DFx_DefineWindow(dtvcc_service_decoder *decoder, int window_id
 		}
 		else
 		{
-			mprint("[CEA-708] dtvcc_handle_DFx_DefineWindow: "
+			mprint(decoder->log, "[CEA-708] dtvcc_handle_DFx_DefineWindow: "
 						   "invalid win_style num %d\n",
 						   window->win_style);
 			dtvcc_window_apply_style(window, &dtvcc_predefined_window_styles[0]);
@@ -1170,19 +1382,15 @@ void dtvcc_handle_DFx_DefineWindow(dtvcc_service_decoder *decoder, int window_id
 	memcpy(window->commands, data + 1, 6);
 
 	if (window->visible)
-		dtvcc_window_update_time_show(window, timing);
-	if (!window->memory_reserved)
 	{
-		for (int i = 0; i < CEA_DTVCC_MAX_ROWS; i++)
-		{
-			free(window->rows[i]);
-		}
+		dtvcc_window_update_time_show(window, timing);
+		decoder->visible_change_seq++;
 	}
 }
 
 void dtvcc_handle_SWA_SetWindowAttributes(dtvcc_service_decoder *decoder, unsigned char *data)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_SWA_SetWindowAttributes: attributes: \n");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_SWA_SetWindowAttributes: attributes: \n");
 
 	int fill_color = (data[1]) & 0x3f;
 	int fill_opacity = (data[1] >> 6) & 0x03;
@@ -1197,16 +1405,16 @@ void dtvcc_handle_SWA_SetWindowAttributes(dtvcc_service_decoder *decoder, unsign
 	int effect_dir = (data[4] >> 2) & 0x03;
 	int effect_speed = (data[4] >> 4) & 0x0f;
 
-	dbg_print(CEA_DMT_708, "       Fill color: [%d]     Fill opacity: [%d]    Border color: [%d]  Border type: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "       Fill color: [%d]     Fill opacity: [%d]    Border color: [%d]  Border type: [%d]\n",
 				     fill_color, fill_opacity, border_color, border_type01);
-	dbg_print(CEA_DMT_708, "          Justify: [%d]       Scroll dir: [%d]       Print dir: [%d]    Word wrap: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "          Justify: [%d]       Scroll dir: [%d]       Print dir: [%d]    Word wrap: [%d]\n",
 				     justify, scroll_dir, print_dir, word_wrap);
-	dbg_print(CEA_DMT_708, "      Border type: [%d]      Display eff: [%d]      Effect dir: [%d] Effect speed: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "      Border type: [%d]      Display eff: [%d]      Effect dir: [%d] Effect speed: [%d]\n",
 				     border_type, display_eff, effect_dir, effect_speed);
 
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_SWA_SetWindowAttributes: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_SWA_SetWindowAttributes: "
 					   "Window has to be defined first\n");
 		return;
 	}
@@ -1230,13 +1438,13 @@ void dtvcc_handle_DLW_DeleteWindows(dtvcc_ctx *dtvcc,
 				    dtvcc_service_decoder *decoder,
 				    int windows_bitmap)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_DLW_DeleteWindows: windows: ");
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_DLW_DeleteWindows: windows: ");
 
 	int screen_content_changed = 0, window_had_content = 0;
 	// int current_win_deleted = 0; /* currently unused */
 
 	if (windows_bitmap == 0)
-		dbg_print(CEA_DMT_708, "none\n");
+		dbg_print(dtvcc->log, CEA_DMT_708, "none\n");
 	else
 	{
 		for (int i = 0; i < CEA_DTVCC_MAX_WINDOWS; i++)
@@ -1244,11 +1452,12 @@ void dtvcc_handle_DLW_DeleteWindows(dtvcc_ctx *dtvcc,
 			if (windows_bitmap & 1)
 			{
 				dtvcc_window *window = &decoder->windows[i];
-				dbg_print(CEA_DMT_708, "[CEA-708] Deleting [W-%d]\n", i);
+				dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] Deleting [W-%d]\n", i);
 				window_had_content = window->is_defined && window->visible && !window->is_empty;
 				if (window_had_content)
 				{
 					screen_content_changed = 1;
+					decoder->visible_change_seq++;
 					dtvcc_window_update_time_hide(window, dtvcc->timing);
 					dtvcc_window_copy_to_screen(decoder, &decoder->windows[i]);
 					if (i == decoder->current_window)
@@ -1271,14 +1480,14 @@ void dtvcc_handle_DLW_DeleteWindows(dtvcc_ctx *dtvcc,
 			windows_bitmap >>= 1;
 		}
 	}
-	dbg_print(CEA_DMT_708, "\n");
+	dbg_print(dtvcc->log, CEA_DMT_708, "\n");
 	if (screen_content_changed && !dtvcc_decoder_has_visible_windows(decoder))
 		dtvcc_screen_print(dtvcc, decoder);
 }
 
 void dtvcc_handle_SPA_SetPenAttributes(dtvcc_service_decoder *decoder, unsigned char *data)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_SPA_SetPenAttributes: attributes: \n");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_SPA_SetPenAttributes: attributes: \n");
 
 	int pen_size = (data[1]) & 0x3;
 	int offset = (data[1] >> 2) & 0x3;
@@ -1288,14 +1497,14 @@ void dtvcc_handle_SPA_SetPenAttributes(dtvcc_service_decoder *decoder, unsigned
 	int underline = (data[2] >> 6) & 0x1;
 	int italic = (data[2] >> 7) & 0x1;
 
-	dbg_print(CEA_DMT_708, "       Pen size: [%d]     Offset: [%d]  Text tag: [%d]   Font tag: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "       Pen size: [%d]     Offset: [%d]  Text tag: [%d]   Font tag: [%d]\n",
 				     pen_size, offset, text_tag, font_tag);
-	dbg_print(CEA_DMT_708, "      Edge type: [%d]  Underline: [%d]    Italic: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "      Edge type: [%d]  Underline: [%d]    Italic: [%d]\n",
 				     edge_type, underline, italic);
 
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_SPA_SetPenAttributes: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_SPA_SetPenAttributes: "
 					   "Window has to be defined first\n");
 		return;
 	}
@@ -1304,7 +1513,7 @@ void dtvcc_handle_SPA_SetPenAttributes(dtvcc_service_decoder *decoder, unsigned
 
 	if (window->pen_row == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_SPA_SetPenAttributes: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_SPA_SetPenAttributes: "
 					   "can't set pen attribs for undefined row\n");
 		return;
 	}
@@ -1322,7 +1531,7 @@ void dtvcc_handle_SPA_SetPenAttributes(dtvcc_service_decoder *decoder, unsigned
 
 void dtvcc_handle_SPC_SetPenColor(dtvcc_service_decoder *decoder, unsigned char *data)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_SPC_SetPenColor: attributes: \n");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_SPC_SetPenColor: attributes: \n");
 
 	int fg_color = (data[1]) & 0x3f;
 	int fg_opacity = (data[1] >> 6) & 0x03;
@@ -1330,16 +1539,16 @@ void dtvcc_handle_SPC_SetPenColor(dtvcc_service_decoder *decoder, unsigned char
 	int bg_opacity = (data[2] >> 6) & 0x03;
 	int edge_color = (data[3]) & 0x3f;
 
-	dbg_print(CEA_DMT_708, "      Foreground color: [%d]     Foreground opacity: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "      Foreground color: [%d]     Foreground opacity: [%d]\n",
 				     fg_color, fg_opacity);
-	dbg_print(CEA_DMT_708, "      Background color: [%d]     Background opacity: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "      Background color: [%d]     Background opacity: [%d]\n",
 				     bg_color, bg_opacity);
-	dbg_print(CEA_DMT_708, "            Edge color: [%d]\n",
+	dbg_print(decoder->log, CEA_DMT_708, "            Edge color: [%d]\n",
 				     edge_color);
 
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_SPC_SetPenColor: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_SPC_SetPenColor: "
 					   "Window has to be defined first\n");
 		return;
 	}
@@ -1348,7 +1557,7 @@ void dtvcc_handle_SPC_SetPenColor(dtvcc_service_decoder *decoder, unsigned char
 
 	if (window->pen_row == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_SPA_SetPenAttributes: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_SPA_SetPenAttributes: "
 					   "can't set pen color for undefined row\n");
 		return;
 	}
@@ -1364,16 +1573,16 @@ void dtvcc_handle_SPC_SetPenColor(dtvcc_service_decoder *decoder, unsigned char
 
 void dtvcc_handle_SPL_SetPenLocation(dtvcc_service_decoder *decoder, unsigned char *data)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_SPL_SetPenLocation: attributes: \n");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_SPL_SetPenLocation: attributes: \n");
 
 	int row = data[1] & 0x0f;
 	int col = data[2] & 0x3f;
 
-	dbg_print(CEA_DMT_708, "      row: [%d]     Column: [%d]\n", row, col);
+	dbg_print(decoder->log, CEA_DMT_708, "      row: [%d]     Column: [%d]\n", row, col);
 
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_SPL_SetPenLocation: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_SPL_SetPenLocation: "
 					   "Window has to be defined first\n");
 		return;
 	}
@@ -1381,7 +1590,7 @@ void dtvcc_handle_SPL_SetPenLocation(dtvcc_service_decoder *decoder, unsigned ch
 	dtvcc_window *window = &decoder->windows[decoder->current_window];
 	if (row >= window->row_count || col >= window->col_count)
 	{
-		mprint("[CEA-708] dtvcc_handle_SPL_SetPenLocation: "
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_SPL_SetPenLocation: "
 					   "Invalid pen location %d:%d for window size %dx%d, rejecting command\n",
 					   row, col, window->row_count, window->col_count);
 		return;
@@ -1400,7 +1609,7 @@ void dtvcc_handle_RST_Reset(dtvcc_service_decoder *decoder)
 
 void dtvcc_handle_DLY_Delay(dtvcc_service_decoder *decoder, int tenths_of_sec)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_DLY_Delay: "
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_DLY_Delay: "
 						  "delay for [%d] tenths of second",
 				     tenths_of_sec);
 	// TODO: Probably ask for the current FTS and wait for this time before resuming - not sure it's worth it though
@@ -1409,7 +1618,7 @@ void dtvcc_handle_DLY_Delay(dtvcc_service_decoder *decoder, int tenths_of_sec)
 
 void dtvcc_handle_DLC_DelayCancel(dtvcc_service_decoder *decoder)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_DLC_DelayCancel");
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_DLC_DelayCancel");
 	// TODO: See above
 }
 
@@ -1419,7 +1628,7 @@ void dtvcc_handle_C0_P16(dtvcc_service_decoder *decoder, unsigned char *data) //
 {
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_C0_P16: Window has to be defined first\n");
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_C0_P16: Window has to be defined first\n");
 	}
 
 	dtvcc_symbol sym;
@@ -1433,7 +1642,7 @@ void dtvcc_handle_C0_P16(dtvcc_service_decoder *decoder, unsigned char *data) //
 		CEA_DTVCC_SYM_SET(sym, data[1]);
 	}
 
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_C0_P16: [%04X]\n", sym.sym);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_C0_P16: [%04X]\n", sym.sym);
 	dtvcc_process_character(decoder, sym);
 }
 
@@ -1442,12 +1651,12 @@ int dtvcc_handle_G0(dtvcc_service_decoder *decoder, unsigned char *data, int dat
 {
 	if (decoder->current_window == -1)
 	{
-		mprint("[CEA-708] dtvcc_handle_G0: Window has to be defined first\n");
+		mprint(decoder->log, "[CEA-708] dtvcc_handle_G0: Window has to be defined first\n");
 		return 1;
 	}
 
 	unsigned char c = data[0];
-	dbg_print(CEA_DMT_708, "[CEA-708] G0: [%02X]  (%c)\n", c, c);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] G0: [%02X]  (%c)\n", c, c);
 	dtvcc_symbol sym;
 	if (c == 0x7F)
 	{ // musical note replaces the Delete command code in ASCII
@@ -1465,7 +1674,7 @@ int dtvcc_handle_G0(dtvcc_service_decoder *decoder, unsigned char *data, int dat
 // G1 Code Set - ISO 8859-1 LATIN-1 Character Set
 int dtvcc_handle_G1(dtvcc_service_decoder *decoder, unsigned char *data, int data_length)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] G1: [%02X]  (%c)\n", data[0], data[0]);
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] G1: [%02X]  (%c)\n", data[0], data[0]);
 	unsigned char c = dtvcc_get_internal_from_G1(data[0]);
 	dtvcc_symbol sym;
 	CEA_DTVCC_SYM_SET(sym, c);
@@ -1483,7 +1692,7 @@ int dtvcc_handle_C0(dtvcc_ctx *dtvcc,
 	if (name == NULL)
 		name = "Reserved";
 
-	dbg_print(CEA_DMT_708, "[CEA-708] C0: [%02X]  (%d)   [%s]\n", c0, data_length, name);
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] C0: [%02X]  (%d)   [%s]\n", c0, data_length, name);
 
 	int len = -1;
 	// These commands have a known length even if they are reserved.
@@ -1511,7 +1720,7 @@ int dtvcc_handle_C0(dtvcc_ctx *dtvcc,
 				dtvcc_process_bs(decoder);
 				break;
 			default:
-				mprint("[CEA-708] dtvcc_handle_C0: unhandled branch\n");
+				mprint(dtvcc->log, "[CEA-708] dtvcc_handle_C0: unhandled branch\n");
 				break;
 		}
 		len = 1;
@@ -1529,18 +1738,18 @@ int dtvcc_handle_C0(dtvcc_ctx *dtvcc,
 			if (data_length >= 3)
 				dtvcc_handle_C0_P16(decoder, data + 1);
 			else
-				dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_C0: Not enough data for P16\n");
+				dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_C0: Not enough data for P16\n");
 		}
 		len = 3;
 	}
 	if (len == -1)
 	{
-		dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_C0: impossible len == -1");
+		dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_C0: impossible len == -1");
 		return -1;
 	}
 	if (len > data_length)
 	{
-		dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_handle_C0: "
+		dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_handle_C0: "
 							  "command is %d bytes long but we only have %d\n",
 					     len, data_length);
 		return -1;
@@ -1555,13 +1764,14 @@ int dtvcc_handle_C1(dtvcc_ctx *dtvcc,
 		    int data_length)
 {
 	struct DTVCC_S_COMMANDS_C1 com = DTVCC_COMMANDS_C1[data[0] - 0x80];
-	dbg_print(CEA_DMT_708, "[CEA-708] C1: %s | [%02X]  [%s] [%s] (%d)\n",
-				     print_mstime_static(get_fts(dtvcc->timing, 3)),
+	char timebuf[CEA_MSTIME_BUF_SIZE];
+	dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] C1: %s | [%02X]  [%s] [%s] (%d)\n",
+				     print_mstime(get_fts(dtvcc->timing, 3), timebuf),
 				     data[0], com.name, com.description, com.length);
 
 	if (com.length > data_length)
 	{
-		dbg_print(CEA_DMT_708, "[CEA-708] C1: Warning: Not enough bytes for command.\n");
+		dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] C1: Warning: Not enough bytes for command.\n");
 		return -1;
 	}
 
@@ -1614,7 +1824,7 @@ int dtvcc_handle_C1(dtvcc_ctx *dtvcc,
 		case DTVCC_C1_RSV94:
 		case DTVCC_C1_RSV95:
 		case DTVCC_C1_RSV96:
-			dbg_print(CEA_DMT_708, "[CEA-708] Warning, found Reserved codes, ignored.\n");
+			dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] Warning, found Reserved codes, ignored.\n");
 			break;
 		case DTVCC_C1_SWA:
 			dtvcc_handle_SWA_SetWindowAttributes(decoder, data);
@@ -1630,7 +1840,7 @@ int dtvcc_handle_C1(dtvcc_ctx *dtvcc,
 			dtvcc_handle_DFx_DefineWindow(decoder, com.code - DTVCC_C1_DF0, data, dtvcc->timing); /* Window 0 to 7 */
 			break;
 		default:
-			mprint("[CEA-708] BUG: Unhandled code in dtvcc_handle_C1.\n");
+			mprint(dtvcc->log, "[CEA-708] BUG: Unhandled code in dtvcc_handle_C1.\n");
 			break;
 	}
 
@@ -1656,7 +1866,7 @@ int dtvcc_handle_C2(dtvcc_service_decoder *decoder, unsigned char *data, int dat
 int dtvcc_handle_C3(dtvcc_service_decoder *decoder, unsigned char *data, int data_length)
 {
 	if (data[0] < 0x80 || data[0] > 0x9F)
-		fatal(
+		fatal(decoder->log,
 		    CEA_COMMON_EXIT_BUG_BUG, "[CEA-708] Entry in dtvcc_handle_C3 with an out of range value.");
 	if (data[0] <= 0x87)	  // 80-87...
 		return 5;	  // ... Five-byte control bytes (4 additional bytes)
@@ -1666,7 +1876,7 @@ int dtvcc_handle_C3(dtvcc_service_decoder *decoder, unsigned char *data, int dat
 
 	// These are variable length commands, that can even span several segments
 	// (they allow even downloading fonts or graphics).
-	fatal(
+	fatal(decoder->log,
 	    CEA_COMMON_EXIT_UNSUPPORTED, "[CEA-708] This sample contains unsupported 708 data. "
 					 "PLEASE help us improve CCExtractor by submitting it.\n");
 	return 0; // Unreachable, but otherwise there's compilers warnings
@@ -1681,7 +1891,7 @@ int dtvcc_handle_C3(dtvcc_service_decoder *decoder, unsigned char *data, int dat
 int dtvcc_handle_extended_char(dtvcc_service_decoder *decoder, unsigned char *data, int data_length)
 {
 	int used;
-	dbg_print(CEA_DMT_708, "[CEA-708] In dtvcc_handle_extended_char, "
+	dbg_print(decoder->log, CEA_DMT_708, "[CEA-708] In dtvcc_handle_extended_char, "
 						  "first data code: [%c], length: [%u]\n",
 				     data[0], data_length);
 	if (data_length < 1)
@@ -1746,7 +1956,7 @@ void dtvcc_process_service_block(dtvcc_ctx *dtvcc,
 
 			if (used == -1)
 			{
-				dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_service_block: "
+				dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_service_block: "
 									  "There was a problem handling the data. Reseting service decoder\n");
 				// TODO: Not sure if a local reset is going to be helpful here.
 				// dtvcc_windows_reset(decoder);
@@ -1775,13 +1985,13 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 {
 	int seq = (dtvcc->current_packet[0] & 0xC0) >> 6; // Two most significants bits
 #ifdef DEBUG_708_PACKETS
-	mprint("[CEA-708] dtvcc_process_current_packet: length=%d, seq=%d\n",
+	mprint(dtvcc->log, "[CEA-708] dtvcc_process_current_packet: length=%d, seq=%d\n",
 				   dtvcc->current_packet_length, seq);
 #endif
 	if (dtvcc->current_packet_length == 0)
 		return;
 #ifdef DEBUG_708_PACKETS
-	mprint("[CEA-708] dtvcc_process_current_packet: "
+	mprint(dtvcc->log, "[CEA-708] dtvcc_process_current_packet: "
 				   "Sequence: %d, packet length: %d\n",
 				   seq, len);
 #endif
@@ -1793,7 +2003,7 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 	if (dtvcc->last_sequence != CEA_DTVCC_NO_LAST_SEQUENCE &&
 	    (dtvcc->last_sequence + 1) % 4 != seq)
 	{
-		dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
+		dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
 							  "Unexpected sequence number, it is [%d] but should be [%d]\n",
 					     seq, (dtvcc->last_sequence + 1) % 4);
 		// WARN: if we reset decoders here, buffer will not be written
@@ -1810,7 +2020,7 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 		int service_number = (pos[0] & 0xE0) >> 5; // 3 more significant bits
 		int block_length = (pos[0] & 0x1F);	   // 5 less significant bits
 
-		dbg_print(
+		dbg_print(dtvcc->log,
 		    CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: Standard header: "
 				 "Service number: [%d] Block length: [%d]\n",
 		    service_number, block_length);
@@ -1819,7 +2029,7 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 		{
 			if (pos + 1 >= dtvcc->current_packet + len)
 			{
-				dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
+				dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
 									  "Truncated extended header, stopping.\n");
 				break;
 			}
@@ -1828,7 +2038,7 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 			// printf ("Extended header: Service number: [%d]\n",service_number);
 			if (service_number < 7)
 			{
-				dbg_print(
+				dbg_print(dtvcc->log,
 				    CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
 						 "Illegal service number in extended header: [%d]\n",
 				    service_number);
@@ -1848,7 +2058,7 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 		pos++;					      // Move to service data
 		if (service_number == 0 && block_length != 0) // Illegal, but specs say what to do...
 		{
-			dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
+			dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
 								  "Data received for service 0, skipping rest of packet.");
 			pos = dtvcc->current_packet + len; // Move to end
 			break;
@@ -1859,8 +2069,9 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 			dtvcc->report->services[service_number] = 1;
 		}
 
-		if (service_number > 0 && dtvcc->services_active[service_number - 1])
-			dtvcc_process_service_block(dtvcc, &dtvcc->decoders[service_number - 1], pos, block_length);
+		// The service decoder is only allocated once its service carries data
+		if (service_number > 0 && block_length > 0 && (dtvcc->services_active >> (service_number - 1) & 1))
+			dtvcc_process_service_block(dtvcc, dtvcc_get_service_decoder(dtvcc, service_number - 1), pos, block_length);
 
 		pos += block_length; // Skip data
 	}
@@ -1869,14 +2080,14 @@ void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len)
 
 	if (pos != dtvcc->current_packet + len) // For some reason we didn't parse the whole packet
 	{
-		dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet:"
+		dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet:"
 							  " There was a problem with this packet, reseting\n");
 		dtvcc_decoders_reset(dtvcc);
 	}
 
 	if (len < 128 && *pos) // Null header is mandatory if there is room
 	{
-		dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
+		dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_current_packet: "
 							  "Warning: Null header expected but not found.\n");
 	}
 }
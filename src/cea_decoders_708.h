@@ -216,24 +216,30 @@ enum dtvcc_pen_anchor_point
 	DTVCC_ANCHOR_POINT_BOTTOM_RIGHT = 8
 };
 
+/**
+ * Pen colors and attributes are stored for every cell of every window and of
+ * the TV screen, so they are packed into one 32-bit word each. Field widths
+ * match the SetPenColor / SetPenAttributes parameters, which lets whole rows
+ * be moved with memcpy.
+ */
 typedef struct dtvcc_pen_color
 {
-	int fg_color;
-	int fg_opacity;
-	int bg_color;
-	int bg_opacity;
-	int edge_color;
+	unsigned int fg_color : 6;
+	unsigned int fg_opacity : 2;
+	unsigned int bg_color : 6;
+	unsigned int bg_opacity : 2;
+	unsigned int edge_color : 6;
 } dtvcc_pen_color;
 
 typedef struct dtvcc_pen_attribs
 {
-	int pen_size;
-	int offset;
-	int text_tag;
-	int font_tag;
-	int edge_type;
-	int underline;
-	int italic;
+	unsigned int pen_size : 2;
+	unsigned int offset : 2;
+	unsigned int text_tag : 4;
+	unsigned int font_tag : 3;
+	unsigned int edge_type : 3;
+	unsigned int underline : 1;
+	unsigned int italic : 1;
 } dtvcc_pen_attribs;
 
 typedef struct dtvcc_window_attribs
@@ -296,12 +302,18 @@ typedef struct dtvcc_window
 	dtvcc_window_attribs attribs;
 	int pen_row;
 	int pen_column;
+	/**
+	 * Cell storage is allocated on first DefineWindow and only grows with
+	 * later definitions: memory_rows x memory_cols cells, never more than
+	 * CEA_DTVCC_MAX_ROWS x CEA_DTVCC_MAX_COLUMNS.
+	 */
 	dtvcc_symbol *rows[CEA_DTVCC_MAX_ROWS];
-	dtvcc_pen_color pen_colors[CEA_DTVCC_MAX_ROWS][CEA_DTVCC_SCREENGRID_COLUMNS];
-	dtvcc_pen_attribs pen_attribs[CEA_DTVCC_MAX_ROWS][CEA_DTVCC_SCREENGRID_COLUMNS];
+	dtvcc_pen_color *pen_colors[CEA_DTVCC_MAX_ROWS];
+	dtvcc_pen_attribs *pen_attribs[CEA_DTVCC_MAX_ROWS];
 	dtvcc_pen_color pen_color_pattern;
 	dtvcc_pen_attribs pen_attribs_pattern;
-	int memory_reserved;
+	int memory_rows;
+	int memory_cols;
 	int is_empty;
 	int64_t time_ms_show;
 	int64_t time_ms_hide;
@@ -309,9 +321,17 @@ typedef struct dtvcc_window
 
 typedef struct dtvcc_tv_screen
 {
-	dtvcc_symbol chars[CEA_DTVCC_SCREENGRID_ROWS][CEA_DTVCC_SCREENGRID_COLUMNS];
-	dtvcc_pen_color pen_colors[CEA_DTVCC_SCREENGRID_ROWS][CEA_DTVCC_SCREENGRID_COLUMNS];
-	dtvcc_pen_attribs pen_attribs[CEA_DTVCC_SCREENGRID_ROWS][CEA_DTVCC_SCREENGRID_COLUMNS];
+	/**
+	 * Cells only cover the part of the CEA_DTVCC_SCREENGRID_ROWS x
+	 * CEA_DTVCC_SCREENGRID_COLUMNS grid that windows were copied to:
+	 * rows x cols cells, row-major, starting at grid row top, column 0.
+	 * The area is allocated on the first copy and only grows.
+	 */
+	dtvcc_symbol *chars;
+	dtvcc_pen_color *pen_colors;
+	dtvcc_pen_attribs *pen_attribs;
+	int top;
+	int rows, cols;
 	int64_t time_ms_show;
 	int64_t time_ms_hide;
 	unsigned int cc_count;
@@ -335,6 +355,8 @@ typedef struct dtvcc_service_decoder
 	int current_window;
 	dtvcc_tv_screen *tv;
 	int cc_count;
+	unsigned int visible_change_seq; // bumped whenever the text of visible windows may have changed
+	const struct cea_logger *log;
 } dtvcc_service_decoder;
 
 typedef struct cea_decoder_dtvcc_settings
@@ -345,6 +367,7 @@ typedef struct cea_decoder_dtvcc_settings
 	int active_services_count;
 	int services_enabled[CEA_DTVCC_MAX_SERVICES];
 	struct cea_common_timing_ctx *timing;
+	const struct cea_logger *log;
 } cea_decoder_dtvcc_settings;
 
 /**
@@ -357,12 +380,13 @@ typedef struct dtvcc_ctx
 {
 	int is_active;
 	int active_services_count;
-	int services_active[CEA_DTVCC_MAX_SERVICES]; // 0 - inactive, 1 - active
+	uint64_t services_active; // bit i set - service i + 1 is decoded
+	unsigned char service_slot[CEA_DTVCC_MAX_SERVICES]; // slot in decoders of each active service
 	int report_enabled;
 
 	cea_decoder_dtvcc_report *report;
 
-	dtvcc_service_decoder decoders[CEA_DTVCC_MAX_SERVICES];
+	dtvcc_service_decoder **decoders; // one slot per active service, allocated when the service first carries data
 
 	unsigned char current_packet[CEA_DTVCC_MAX_PACKET_LENGTH];
 	int current_packet_length;
@@ -370,13 +394,18 @@ typedef struct dtvcc_ctx
 
 	int last_sequence;
 
-	struct cc_subtitle *current_sub; // subtitle output destination (set per process_cc_data call)
+	struct cc_caption_ring *ring; // caption output (set per process_cc_data call)
+	dtvcc_tv_screen *live_tv;     // scratch screen for dtvcc_visible_text, allocated on first use
+	char *live_text;              // text returned by dtvcc_visible_text, reused across calls
+	size_t live_text_size;
 	struct cea_common_timing_ctx *timing;
+	const struct cea_logger *log;
 } dtvcc_ctx;
 
 void dtvcc_clear_packet(dtvcc_ctx *ctx);
 void dtvcc_windows_reset(dtvcc_service_decoder *decoder);
 void dtvcc_decoder_flush(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder);
+const char *dtvcc_visible_text(dtvcc_ctx *dtvcc, dtvcc_service_decoder *decoder, int64_t *time_ms_show, int *bottom_row);
 
 void dtvcc_process_current_packet(dtvcc_ctx *dtvcc, int len);
 void dtvcc_process_service_block(dtvcc_ctx *dtvcc,
@@ -385,6 +414,7 @@ void dtvcc_process_service_block(dtvcc_ctx *dtvcc,
 				 int data_length);
 
 void dtvcc_tv_clear(dtvcc_service_decoder *decoder);
+void dtvcc_tv_free(dtvcc_tv_screen *tv);
 int dtvcc_decoder_has_visible_windows(dtvcc_service_decoder *decoder);
 void dtvcc_window_clear_row(dtvcc_window *window, int row_index);
 void dtvcc_window_clear_text(dtvcc_window *window);
@@ -398,11 +428,21 @@ void dtvcc_window_dump(dtvcc_service_decoder *decoder, dtvcc_window *window);
 #endif
 
 void dtvcc_decoders_reset(dtvcc_ctx *dtvcc);
+dtvcc_service_decoder *dtvcc_get_service_decoder(dtvcc_ctx *dtvcc, int service_index);
+
+/* Decoder of an active service, or NULL if it has not carried data yet */
+dtvcc_service_decoder *dtvcc_service_decoder_of(const dtvcc_ctx *dtvcc, int service_index);
+
+/* Remove the lowest service index from an active-service mask and return it.
+ * The mask must not be 0. */
+int dtvcc_next_service(uint64_t *mask);
+void dtvcc_service_decoder_free(dtvcc_service_decoder *decoder);
+void dtvcc_window_reserve(dtvcc_service_decoder *decoder, dtvcc_window *window, int row_count, int col_count);
 int dtvcc_compare_win_priorities(const void *a, const void *b);
 void dtvcc_window_update_time_show(dtvcc_window *window, struct cea_common_timing_ctx *timing);
 void dtvcc_window_update_time_hide(dtvcc_window *window, struct cea_common_timing_ctx *timing);
-void dtvcc_screen_update_time_show(dtvcc_tv_screen *tv, int64_t time);
-void dtvcc_screen_update_time_hide(dtvcc_tv_screen *tv, int64_t time);
+void dtvcc_screen_update_time_show(dtvcc_service_decoder *decoder, int64_t time);
+void dtvcc_screen_update_time_hide(dtvcc_service_decoder *decoder, int64_t time);
 void dtvcc_get_window_dimensions(dtvcc_window *window, int *x1, int *x2, int *y1, int *y2);
 int dtvcc_is_window_overlapping(dtvcc_service_decoder *decoder, dtvcc_window *window);
 void dtvcc_window_copy_to_screen(dtvcc_service_decoder *decoder, dtvcc_window *window);
@@ -11,41 +11,31 @@
 #include "cea_common_common.h"
 #include "cea_common_constants.h"
 #include "cea_common_structs.h"
+#include "cea_caption_ring.h"
 
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-static int dtvcc_is_row_empty(dtvcc_tv_screen *tv, int row_index)
-{
-	for (int j = 0; j < CEA_DTVCC_SCREENGRID_COLUMNS; j++)
-	{
-		if (CEA_DTVCC_SYM_IS_SET(tv->chars[row_index][j]))
-			return 0;
-	}
-	return 1;
-}
-
-static int dtvcc_is_screen_empty_lite(dtvcc_tv_screen *tv)
-{
-	for (int i = 0; i < CEA_DTVCC_SCREENGRID_ROWS; i++)
-	{
-		if (!dtvcc_is_row_empty(tv, i))
-			return 0;
-	}
-	return 1;
-}
-
+/* Columns (within the screen area) of the first and last symbols set in
+   a row; first is tv->cols if the row is empty */
 static void dtvcc_get_write_interval(dtvcc_tv_screen *tv, int row_index, int *first, int *last)
 {
-	for (*first = 0; *first < CEA_DTVCC_SCREENGRID_COLUMNS; (*first)++)
-		if (CEA_DTVCC_SYM_IS_SET(tv->chars[row_index][*first]))
+	const dtvcc_symbol *row = tv->chars + (size_t)row_index * tv->cols;
+	for (*first = 0; *first < tv->cols; (*first)++)
+		if (CEA_DTVCC_SYM_IS_SET(row[*first]))
 			break;
-	for (*last = CEA_DTVCC_SCREENGRID_COLUMNS - 1; *last > 0; (*last)--)
-		if (CEA_DTVCC_SYM_IS_SET(tv->chars[row_index][*last]))
+	for (*last = tv->cols - 1; *last > 0; (*last)--)
+		if (CEA_DTVCC_SYM_IS_SET(row[*last]))
 			break;
 }
 
+/* Upper bound of output bytes per cell: closing </u></i></font>, opening
+   <font color="#RRGGBB"><i><u> and a 3-byte UTF-8 symbol */
+#define DTVCC_MAX_CELL_BYTES (4 + 4 + 7 + 22 + 3 + 3 + 3)
+/* Upper bound of output bytes per row besides its cells: '\n' and the closing tags */
+#define DTVCC_MAX_ROW_EXTRA_BYTES (1 + 4 + 4 + 7)
+
 /* Encode a Unicode code point (16-bit) as UTF-8.
    Returns number of bytes written (1-3). */
 static int encode_utf8(unsigned short cp, char *out)
@@ -84,37 +74,45 @@ static const char *color_708_hex(int color, char *buf)
 	return buf;
 }
 
-/* Extract all text from a 708 screen into a cc_subtitle.
-   Text from multiple rows is joined with '\n'.
-   Includes SRT-style <i>, <u>, <font color> tags for styling. */
-int dtvcc_screen_to_subtitle(dtvcc_tv_screen *tv, struct cc_subtitle *sub)
+/* Find the written interval of every row of the screen area and return
+   the number of bytes the styled text can take at most, including the
+   terminating NUL. bottom_row is the last written row of the area.
+   Returns 0 if the screen is empty. */
+static size_t dtvcc_screen_text_bound(dtvcc_tv_screen *tv, int *first_col, int *last_col, int *bottom_row)
 {
-	if (dtvcc_is_screen_empty_lite(tv))
-		return 0;
+	size_t bound = 1;
 
-	/* Allocate generously: styled text can be much larger than plain */
-	size_t buf_capacity = CEA_DTVCC_SCREENGRID_ROWS * CEA_DTVCC_SCREENGRID_COLUMNS * 60 + 256;
-	char *buf = (char *)malloc(buf_capacity);
-	if (!buf)
-		return -1;
+	*bottom_row = -1;
+	for (int i = 0; i < tv->rows; i++)
+	{
+		dtvcc_get_write_interval(tv, i, &first_col[i], &last_col[i]);
+		if (first_col[i] == tv->cols)
+			continue;
+		*bottom_row = i;
+		bound += (size_t)(last_col[i] - first_col[i] + 1) * DTVCC_MAX_CELL_BYTES + DTVCC_MAX_ROW_EXTRA_BYTES;
+	}
+	return *bottom_row < 0 ? 0 : bound;
+}
 
+/* Render the styled text of rows 0..bottom_row into buf, which must hold
+   the bound computed by dtvcc_screen_text_bound. Text from multiple rows is
+   joined with '\n', styling uses SRT-style <i>, <u>, <font color> tags.
+   Returns the text length. */
+static size_t dtvcc_screen_render_text(dtvcc_tv_screen *tv, const int *first_col, const int *last_col, int bottom_row, char *buf)
+{
 	size_t buf_len = 0;
 	int rows_written = 0;
-	int bottom_row = -1;
 
-	for (int i = 0; i < CEA_DTVCC_SCREENGRID_ROWS; i++)
+	for (int i = 0; i <= bottom_row; i++)
 	{
-		if (dtvcc_is_row_empty(tv, i))
+		int first = first_col[i], last = last_col[i];
+		if (first == tv->cols)
 			continue;
-
-		bottom_row = i;
+		size_t row = (size_t)i * tv->cols;
 
 		if (rows_written > 0)
 			buf[buf_len++] = '\n';
 
-		int first, last;
-		dtvcc_get_write_interval(tv, i, &first, &last);
-
 		/* Track current style state for this row */
 		int cur_fg = 0x3F; /* white = default = no tag */
 		int has_font_tag = 0;
@@ -124,9 +122,9 @@ int dtvcc_screen_to_subtitle(dtvcc_tv_screen *tv, struct cc_subtitle *sub)
 
 		for (int j = first; j <= last; j++)
 		{
-			int want_italic = tv->pen_attribs[i][j].italic;
-			int want_underline = tv->pen_attribs[i][j].underline;
-			int want_fg = tv->pen_colors[i][j].fg_color;
+			int want_italic = tv->pen_attribs[row + j].italic;
+			int want_underline = tv->pen_attribs[row + j].underline;
+			int want_fg = tv->pen_colors[row + j].fg_color;
 
 			/* Close tags if style changed (reverse order) */
 			if (cur_underline && !want_underline)
@@ -153,8 +151,8 @@ int dtvcc_screen_to_subtitle(dtvcc_tv_screen *tv, struct cc_subtitle *sub)
 			{ memcpy(buf + buf_len, "<u>", 3); buf_len += 3; cur_underline = 1; }
 
 			/* Write the character */
-			if (CEA_DTVCC_SYM_IS_SET(tv->chars[i][j]))
-				buf_len += encode_utf8(tv->chars[i][j].sym, buf + buf_len);
+			if (CEA_DTVCC_SYM_IS_SET(tv->chars[row + j]))
+				buf_len += encode_utf8(tv->chars[row + j].sym, buf + buf_len);
 			else
 				buf[buf_len++] = ' ';
 		}
@@ -170,31 +168,65 @@ int dtvcc_screen_to_subtitle(dtvcc_tv_screen *tv, struct cc_subtitle *sub)
 		rows_written++;
 	}
 
-	if (rows_written == 0)
-	{
-		free(buf);
+	buf[buf_len] = '\0';
+	return buf_len;
+}
+
+/* Extract all text from a 708 screen into a caption ring event.
+   The text is rendered straight into the event's buffer, sized from the
+   written interval of each row. */
+int dtvcc_screen_to_subtitle(dtvcc_tv_screen *tv, struct cc_caption_ring *ring)
+{
+	int first_col[CEA_DTVCC_SCREENGRID_ROWS];
+	int last_col[CEA_DTVCC_SCREENGRID_ROWS];
+	int bottom_row;
+
+	size_t buf_capacity = dtvcc_screen_text_bound(tv, first_col, last_col, &bottom_row);
+	if (!buf_capacity)
 		return 0;
+
+	struct cc_caption_event *event = cc_ring_push(ring);
+	if (!event)
+		return -1;
+	if (cc_ring_reserve_text(ring, event, buf_capacity) < 0)
+	{
+		cc_ring_drop_last(ring);
+		return -1;
 	}
 
-	buf[buf_len] = '\0';
+	dtvcc_screen_render_text(tv, first_col, last_col, bottom_row, event->text);
 
+	event->type = CC_TEXT;
+	event->start_time = tv->time_ms_show;
+	event->end_time = tv->time_ms_hide;
+	event->flags = tv->top + bottom_row;
+	event->mode = CEA_MODE_POPON;
 	/* Encode service number into info: "7XX" (e.g. "701" = service 1).
 	 * collect_captions decodes this back into cea_caption.channel. */
-	char info_str[4];
-	snprintf(info_str, sizeof(info_str), "7%02d", tv->service_number);
-	int ret = add_cc_sub_text(sub, buf, tv->time_ms_show, tv->time_ms_hide,
-				  info_str, CEA_MODE_POPON);
-
-	/* Store bottom row on the node that add_cc_sub_text just wrote.
-	 * It's always the tail of the chain. */
-	if (ret == 0)
+	snprintf(event->info, sizeof(event->info), "7%02d", tv->service_number);
+	return 0;
+}
+
+/* Render the styled text of a 708 screen into the caller's buffer, which
+   only grows. Returns NULL if the screen is empty. */
+const char *dtvcc_screen_to_text(dtvcc_tv_screen *tv, char **buf, size_t *buf_size, int *bottom_row)
+{
+	int first_col[CEA_DTVCC_SCREENGRID_ROWS];
+	int last_col[CEA_DTVCC_SCREENGRID_ROWS];
+
+	size_t buf_capacity = dtvcc_screen_text_bound(tv, first_col, last_col, bottom_row);
+	if (!buf_capacity)
+		return NULL;
+
+	if (buf_capacity > *buf_size)
 	{
-		struct cc_subtitle *tail = sub;
-		while (tail->next)
-			tail = tail->next;
-		tail->flags = bottom_row;
+		char *grown = (char *)realloc(*buf, buf_capacity);
+		if (!grown)
+			return NULL;
+		*buf = grown;
+		*buf_size = buf_capacity;
 	}
-
-	free(buf);
-	return ret;
+	dtvcc_screen_render_text(tv, first_col, last_col, *bottom_row, *buf);
+	*bottom_row += tv->top;
+	return *buf;
 }
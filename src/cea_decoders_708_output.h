@@ -12,8 +12,13 @@
 #include "cea_decoders_708.h"
 #include "cea_common_structs.h"
 
-/* Extract all text from a 708 screen into a cc_subtitle chain.
+/* Extract all text from a 708 screen into a caption ring event.
    Returns 0 on success, -1 on error. */
-int dtvcc_screen_to_subtitle(dtvcc_tv_screen *tv, struct cc_subtitle *sub);
+int dtvcc_screen_to_subtitle(dtvcc_tv_screen *tv, struct cc_caption_ring *ring);
+
+/* Render the text of a 708 screen into *buf, growing it (and *buf_size)
+   with realloc as needed; the caller owns the buffer and reuses it.
+   Returns *buf, or NULL if the screen is empty or out of memory. */
+const char *dtvcc_screen_to_text(dtvcc_tv_screen *tv, char **buf, size_t *buf_size, int *bottom_row);
 
 #endif /*CEA_DECODERS_708_OUTPUT_H*/
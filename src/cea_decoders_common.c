@@ -24,123 +24,134 @@ int64_t cea_get_visible_end(struct cea_common_timing_ctx *ctx, int current_field
 
 int64_t get_visible_start(struct cea_common_timing_ctx *ctx, int current_field)
 {
+	char buf[CEA_MSTIME_BUF_SIZE];
 	int64_t fts = cea_get_visible_start(ctx, current_field);
-	dbg_print(CEA_DMT_DECODER_608, "Visible Start time=%s\n", print_mstime_static(fts));
+	dbg_print(ctx->log, CEA_DMT_DECODER_608, "Visible Start time=%s\n", print_mstime(fts, buf));
 	return fts;
 }
 
 int64_t get_visible_end(struct cea_common_timing_ctx *ctx, int current_field)
 {
+	char buf[CEA_MSTIME_BUF_SIZE];
 	int64_t fts = cea_get_visible_end(ctx, current_field);
-	dbg_print(CEA_DMT_DECODER_608, "Visible End time=%s\n", print_mstime_static(fts));
+	dbg_print(ctx->log, CEA_DMT_DECODER_608, "Visible End time=%s\n", print_mstime(fts, buf));
 	return fts;
 }
 
-/* Modified: removed encoder_ctx parameter, removed MCC path, uses C DTVCC */
-int process_cc_data(struct lib_cc_decode *dec_ctx, unsigned char *cc_data, int cc_count, struct cc_subtitle *sub)
+/* What do_cb needs of a cc_data triplet, looked up by the cc_valid and
+ * cc_type bits of its header byte. DTVCC packet assembly reads the array
+ * on its own. */
+#define CC_TO_CB  1 // Counted and dispatched by do_cb
+#define CC_IS_608 2 // EIA-608 pair: parity checked, null padding dropped
+
+static const unsigned char cc_triplet_route[8] = {
+	0,                    // Invalid field 1
+	0,                    // Invalid field 2
+	0,                    // Invalid DTVCC packet data
+	0,                    // Invalid DTVCC packet start
+	CC_TO_CB | CC_IS_608, // Field 1
+	CC_TO_CB | CC_IS_608, // Field 2
+	CC_TO_CB,             // DTVCC packet data
+	CC_TO_CB,             // DTVCC packet start
+};
+
+/* Triplets classified per pass. cc_count is a 5 bit field, so real
+ * cc_data arrays always fit in one pass. */
+#define CC_PASS_TRIPLETS 32
+
+/* Modified: removed encoder_ctx parameter, removed MCC path, uses C DTVCC.
+ * Each pass hands a run of triplets to the DTVCC packet assembler, then
+ * classifies them once and feeds the rest, in stream order, to do_cb. */
+int process_cc_data(struct lib_cc_decode *dec_ctx, const unsigned char *cc_data, int cc_count, struct cc_caption_ring *ring)
 {
 	int ret = -1;
+	int dtvcc_active = dec_ctx->dtvcc && dec_ctx->dtvcc->is_active;
 
-	/* Process DTVCC (708) data directly in C.
-	 * Note: dtvcc->current_sub must be set by the caller so that 708
-	 * output goes to a separate subtitle chain from 608.  This avoids
-	 * memory corruption when both decoders produce output in the same
-	 * call (608 uses realloc on sub->data while 708 uses add_cc_sub_text). */
-	if (dec_ctx->dtvcc && dec_ctx->dtvcc->is_active)
-	{
-		for (int j = 0; j < cc_count * 3; j += 3)
-		{
-			unsigned char cc_valid = (cc_data[j] & 4) >> 2;
-			unsigned char cc_type = cc_data[j] & 3;
-			if ((cc_valid || cc_type == 3) && cc_type >= 2)
-			{
-				unsigned char dtvcc_data[4];
-				dtvcc_data[0] = cc_valid;
-				dtvcc_data[1] = cc_type;
-				dtvcc_data[2] = cc_data[j + 1];
-				dtvcc_data[3] = cc_data[j + 2];
-				dtvcc_process_data(dec_ctx->dtvcc, dtvcc_data);
-			}
-		}
-	}
+	/* 608 and 708 captions go to the same caption ring. */
+	if (dtvcc_active)
+		dec_ctx->dtvcc->ring = ring;
 
-	/* Process 608 data */
-	for (int j = 0; j < cc_count * 3; j = j + 3)
+	for (int first = 0; first < cc_count; first += CC_PASS_TRIPLETS)
 	{
-		if (validate_cc_data_pair(cc_data + j))
-			continue;
-		ret = do_cb(dec_ctx, cc_data + j, sub);
-		if (ret == 1)
-			ret = 0;
-	}
-	return ret;
-}
-
-int validate_cc_data_pair(unsigned char *cc_data_pair)
-{
-	unsigned char cc_valid = (*cc_data_pair & 4) >> 2;
-	unsigned char cc_type = *cc_data_pair & 3;
+		int n = cc_count - first < CC_PASS_TRIPLETS ? cc_count - first : CC_PASS_TRIPLETS;
+		unsigned char cb_list[CC_PASS_TRIPLETS][3];
+		int cb_count = 0;
 
-	if (!cc_valid)
-		return -1;
+		/* Process DTVCC (708) data directly in C. */
+		if (dtvcc_active)
+			dtvcc_process_cc_data(dec_ctx->dtvcc, cc_data + first * 3, n);
 
-	if (cc_type == 0 || cc_type == 1)
-	{
-		if (!cc608_parity_table[cc_data_pair[2]])
+		for (int k = 0; k < n; k++)
 		{
-			return -1;
+			const unsigned char *t = cc_data + (first + k) * 3;
+			unsigned char route = cc_triplet_route[t[0] & 7];
+
+			if (!(route & CC_TO_CB))
+				continue;
+
+			unsigned char d1 = t[1];
+			if (route & CC_IS_608)
+			{
+				if (!cc608_parity_table[t[2]])
+					continue;
+				if (!cc608_parity_table[d1])
+					d1 = 0x7F;
+				if ((t[0] == 0xFC || t[0] == 0xFD) && !((d1 | t[2]) & 0x7F))
+				{
+					ret = 0; // Null padding, valid but nothing to decode
+					continue;
+				}
+			}
+			cb_list[cb_count][0] = t[0];
+			cb_list[cb_count][1] = d1;
+			cb_list[cb_count][2] = t[2];
+			cb_count++;
 		}
-		if (!cc608_parity_table[cc_data_pair[1]])
+
+		/* Process 608 data */
+		for (int k = 0; k < cb_count; k++)
 		{
-			cc_data_pair[1] = 0x7F;
+			ret = do_cb(dec_ctx, cb_list[k], ring);
+			if (ret == 1)
+				ret = 0;
 		}
 	}
-	return 0;
+	return ret;
 }
 
-int do_cb(struct lib_cc_decode *ctx, unsigned char *cc_block, struct cc_subtitle *sub)
+/* cc_block is a valid triplet that process_cc_data already checked for
+ * parity and null padding */
+int do_cb(struct lib_cc_decode *ctx, unsigned char *cc_block, struct cc_caption_ring *ring)
 {
-	unsigned char cc_valid = (*cc_block & 4) >> 2;
 	unsigned char cc_type = *cc_block & 3;
+	char timebuf[CEA_MSTIME_BUF_SIZE];
+	unsigned char asc[3];
 
-	if ((cc_block[0] == 0xFA || cc_block[0] == 0xFC || cc_block[0] == 0xFD) && (cc_block[1] & 0x7F) == 0 && (cc_block[2] & 0x7F) == 0)
-		return 1;
-
-	dbg_print(CEA_DMT_CBRAW, "%s   %02X:%c%c:%02X", print_mstime_static(ctx->timing->fts_now + ctx->timing->fts_global),
+	dbg_print(ctx->log, CEA_DMT_CBRAW, "%s   %02X:%c%c:%02X", print_mstime(ctx->timing->fts_now + ctx->timing->fts_global, timebuf),
 		  cc_block[0], cc_block[1] & 0x7f, cc_block[2] & 0x7f, cc_block[2]);
 
-	if (cc_valid || cc_type == 3)
-	{
-		ctx->cc_stats[cc_type]++;
+	ctx->cc_stats[cc_type]++;
 
-		switch (cc_type)
-		{
-			case 0:
-				dbg_print(CEA_DMT_CBRAW, "    %s   ..   ..\n", debug_608_to_ASC(cc_block, 0));
-				ctx->current_field = 1;
-				printdata(ctx, cc_block + 1, 2, 0, 0, sub);
-				cb_field1++;
-				break;
-			case 1:
-				dbg_print(CEA_DMT_CBRAW, "    ..   %s   ..\n", debug_608_to_ASC(cc_block, 1));
-				ctx->current_field = 2;
-				printdata(ctx, 0, 0, cc_block + 1, 2, sub);
-				cb_field2++;
-				break;
-			case 2:
-			case 3:
-				dbg_print(CEA_DMT_CBRAW, "    ..   ..   DD\n");
-				ctx->current_field = 3;
-				cb_708++;
-				break;
-			default:
-				fatal(CEA_COMMON_EXIT_BUG_BUG, "In do_cb: Impossible value for cc_type.\n");
-		}
-	}
-	else
+	switch (cc_type)
 	{
-		dbg_print(CEA_DMT_CBRAW, "    ..   ..   ..\n");
-		dbg_print(CEA_DMT_VERBOSE, "Found !(cc_valid || cc_type==3) - ignore this block\n");
+		case 0:
+			dbg_print(ctx->log, CEA_DMT_CBRAW, "    %s   ..   ..\n", debug_608_to_ASC(cc_block, 0, asc));
+			ctx->current_field = 1;
+			printdata(ctx, cc_block + 1, 2, 0, 0, ring);
+			ctx->timing->cb_field1++;
+			break;
+		case 1:
+			dbg_print(ctx->log, CEA_DMT_CBRAW, "    ..   %s   ..\n", debug_608_to_ASC(cc_block, 1, asc));
+			ctx->current_field = 2;
+			printdata(ctx, 0, 0, cc_block + 1, 2, ring);
+			ctx->timing->cb_field2++;
+			break;
+		case 2:
+		case 3:
+			dbg_print(ctx->log, CEA_DMT_CBRAW, "    ..   ..   DD\n");
+			ctx->current_field = 3;
+			ctx->timing->cb_708++;
+			break;
 	}
 
 	return 1;
@@ -164,48 +175,50 @@ struct lib_cc_decode *init_cc_decode(struct cea_decoders_common_settings_t *sett
 
 	ctx = (struct lib_cc_decode *)malloc(sizeof(struct lib_cc_decode));
 	if (!ctx)
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory allocating ctx.");
+		fatal(setting->log, EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory allocating ctx.");
 
 	memset(ctx, 0, sizeof(*ctx));
+	ctx->log = setting->log;
 
-	ctx->timing = init_timing_ctx(&cea_common_timing_settings);
+	ctx->timing = init_timing_ctx(setting->settings_timing);
 	if (!ctx->timing)
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing timing.");
+		fatal(ctx->log, EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing timing.");
+	ctx->timing->log = ctx->log;
 
 	setting->settings_dtvcc->timing = ctx->timing;
+	setting->settings_dtvcc->log = ctx->log;
 
 	/* Always use C dtvcc */
 	ctx->dtvcc = dtvcc_init(setting->settings_dtvcc);
 	if (!ctx->dtvcc)
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing dtvcc.");
+		fatal(ctx->log, EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing dtvcc.");
 	ctx->dtvcc->is_active = setting->settings_dtvcc->enabled;
 
-	ctx->context_cc608_field_1_ch1 = cea_decoder_608_init_library(
-		setting->settings_608, 1, 1,
-		&ctx->processed_enough, 0, ctx->timing);
-	if (!ctx->context_cc608_field_1_ch1)
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing CC1 context.");
-
-	ctx->context_cc608_field_1_ch2 = cea_decoder_608_init_library(
-		setting->settings_608, 2, 1,
-		&ctx->processed_enough, 0, ctx->timing);
-	if (!ctx->context_cc608_field_1_ch2)
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing CC2 context.");
-
-	ctx->context_cc608_field_2_ch1 = cea_decoder_608_init_library(
-		setting->settings_608, 1, 2,
-		&ctx->processed_enough, 0, ctx->timing);
-	if (!ctx->context_cc608_field_2_ch1)
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing CC3 context.");
-
-	ctx->context_cc608_field_2_ch2 = cea_decoder_608_init_library(
-		setting->settings_608, 2, 2,
-		&ctx->processed_enough, 0, ctx->timing);
-	if (!ctx->context_cc608_field_2_ch2)
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing CC4 context.");
+	/* CC1, CC2, CC3, CC4. Disabled channels keep a NULL context and
+	 * process608 drops the pairs addressed to them. */
+	void **cc608[4] = {
+		&ctx->context_cc608_field_1_ch1,
+		&ctx->context_cc608_field_1_ch2,
+		&ctx->context_cc608_field_2_ch1,
+		&ctx->context_cc608_field_2_ch2,
+	};
+	for (int i = 0; i < 4; i++)
+	{
+		if (setting->disable_608 & (1 << i))
+			continue;
+		*cc608[i] = cea_decoder_608_init_library(
+			setting->settings_608, i % 2 + 1, i / 2 + 1,
+			&ctx->processed_enough, 0, ctx->timing, ctx->log);
+		if (!*cc608[i])
+			fatal(ctx->log, EXIT_NOT_ENOUGH_MEMORY, "In init_cc_decode: Out of memory initializing CC%d context.", i + 1);
+	}
+	for (int f = 0; f < 2; f++)
+	{
+		ctx->field_608[f].channel = 1;
+		ctx->field_608[f].new_channel = 1;
+	}
 
 	ctx->current_field = 1;
-	ctx->current_channel = 1;
 	ctx->extract = setting->extract;
 
 	/* Always use process608 for writedata in lite */
@@ -214,26 +227,20 @@ struct lib_cc_decode *init_cc_decode(struct cea_decoders_common_settings_t *sett
 	return ctx;
 }
 
-void flush_cc_decode(struct lib_cc_decode *ctx, struct cc_subtitle *sub)
+void flush_cc_decode(struct lib_cc_decode *ctx, struct cc_caption_ring *ring)
 {
 	if (ctx->extract != 2)
-	{
-		flush_608_context(ctx->context_cc608_field_1_ch1, sub);
-		flush_608_context(ctx->context_cc608_field_1_ch2, sub);
-	}
+		flush_608_field(ctx, 1, ring);
 	if (ctx->extract != 1)
-	{
-		flush_608_context(ctx->context_cc608_field_2_ch1, sub);
-		flush_608_context(ctx->context_cc608_field_2_ch2, sub);
-	}
+		flush_608_field(ctx, 2, ring);
 
 	if (ctx->dtvcc && ctx->dtvcc->is_active)
 	{
-		/* dtvcc->current_sub must already be set by the caller */
-		for (int i = 0; i < CEA_DTVCC_MAX_SERVICES; i++)
+		ctx->dtvcc->ring = ring;
+		for (int i = 0; i < ctx->dtvcc->active_services_count; i++)
 		{
-			dtvcc_service_decoder *decoder = &ctx->dtvcc->decoders[i];
-			if (!ctx->dtvcc->services_active[i])
+			dtvcc_service_decoder *decoder = ctx->dtvcc->decoders[i];
+			if (!decoder)
 				continue;
 			if (decoder->cc_count > 0)
 			{
@@ -19,13 +19,12 @@
 int64_t get_visible_start(struct cea_common_timing_ctx *ctx, int current_field);
 int64_t get_visible_end(struct cea_common_timing_ctx *ctx, int current_field);
 
-int validate_cc_data_pair(unsigned char *cc_data_pair);
-int process_cc_data(struct lib_cc_decode *ctx, unsigned char *cc_data, int cc_count, struct cc_subtitle *sub);
-int do_cb(struct lib_cc_decode *ctx, unsigned char *cc_block, struct cc_subtitle *sub);
+int process_cc_data(struct lib_cc_decode *ctx, const unsigned char *cc_data, int cc_count, struct cc_caption_ring *ring);
+int do_cb(struct lib_cc_decode *ctx, unsigned char *cc_block, struct cc_caption_ring *ring);
 void printdata(struct lib_cc_decode *ctx, const unsigned char *data1, int length1,
-	       const unsigned char *data2, int length2, struct cc_subtitle *sub);
+	       const unsigned char *data2, int length2, struct cc_caption_ring *ring);
 struct lib_cc_decode *init_cc_decode(struct cea_decoders_common_settings_t *setting);
 void dinit_cc_decode(struct lib_cc_decode **ctx);
-void flush_cc_decode(struct lib_cc_decode *ctx, struct cc_subtitle *sub);
+void flush_cc_decode(struct lib_cc_decode *ctx, struct cc_caption_ring *ring);
 
 #endif
@@ -59,15 +59,21 @@ enum cea_decoder_608_color_code
 	COL_MAX
 };
 
+/* A cell style byte packs the color code (low nibble) and the font bits */
+#define CEA_608_STYLE(color, font) ((unsigned char)((color) | ((font) << 4)))
+#define CEA_608_STYLE_COLOR(style) ((enum cea_decoder_608_color_code)((style) & 0x0f))
+#define CEA_608_STYLE_FONT(style) ((enum font_bits)(((style) >> 4) & 0x03))
+
+#define CEA_608_ROW_BIT(row) ((uint16_t)(1u << (row)))
+
 struct eia608_screen // A CC buffer
 {
 	/** format of data inside this structure */
 	enum cea_eia608_format format;
-	unsigned char characters[CEA_DECODER_608_SCREEN_ROWS][CEA_DECODER_608_SCREEN_WIDTH + 1];
-	enum cea_decoder_608_color_code colors[CEA_DECODER_608_SCREEN_ROWS][CEA_DECODER_608_SCREEN_WIDTH + 1];
-	enum font_bits fonts[CEA_DECODER_608_SCREEN_ROWS][CEA_DECODER_608_SCREEN_WIDTH + 1]; // Extra char at the end for a 0
-	int row_used[CEA_DECODER_608_SCREEN_ROWS];					     // Any data in row?
-	int empty;									     // Buffer completely empty?
+	unsigned char characters[CEA_DECODER_608_SCREEN_ROWS][CEA_DECODER_608_SCREEN_WIDTH + 1]; // Extra char at the end for a 0
+	unsigned char styles[CEA_DECODER_608_SCREEN_ROWS][CEA_DECODER_608_SCREEN_WIDTH + 1];     // CEA_608_STYLE() per cell
+	uint16_t row_used;										 // Bit n set if row n has any data
+	int empty;											 // Buffer completely empty?
 	/** start time of this CC buffer */
 	int64_t start_time;
 	/** end time of this CC buffer */
@@ -78,11 +84,24 @@ struct eia608_screen // A CC buffer
 	int my_channel; // EIA-608 channel within the field (1 or 2)
 };
 
+/* EIA-608 data channel selection of one field. Both channel contexts of
+ * the field follow the same control codes, so the state is kept once per
+ * field and process608 hands each pair to the selected context only. */
+struct cea_608_field_state
+{
+	int channel;     // Currently selected data channel (1 or 2)
+	int new_channel; // Channel named by the last control code
+	unsigned char last_c1, last_c2; // Last control code, to drop its repetition
+};
+
 struct cea_decoders_common_settings_t
 {
 	int extract; // Extract 1st, 2nd or both fields
+	int disable_608; // cea_608_channel_mask of EIA-608 channels not to decode
 	struct cea_decoder_608_settings *settings_608; // Contains the settings for the 608 decoder.
 	cea_decoder_dtvcc_settings *settings_dtvcc;    // Same for cea 708 captions decoder (dtvcc)
+	struct cea_common_timing_settings_t *settings_timing; // Copied into the timing context
+	const struct cea_logger *log;                  // Logger of the owning context
 };
 
 struct lib_cc_decode
@@ -101,13 +120,15 @@ struct lib_cc_decode
 	void *context_cc608_field_2_ch1;
 	void *context_cc608_field_2_ch2;
 
+	struct cea_608_field_state field_608[2];
+
 	int extract;          // Extract 1st, 2nd or both fields
 	int current_field;    // 1 or 2, set by printdata before calling writedata
-	int current_channel;  // 1 or 2, set by printdata before calling writedata
 
 	struct cea_common_timing_ctx *timing;
 	dtvcc_ctx *dtvcc;
-	int (*writedata)(const unsigned char *data, int length, void *private_data, struct cc_subtitle *sub);
+	const struct cea_logger *log;
+	int (*writedata)(const unsigned char *data, int length, void *private_data, struct cc_caption_ring *ring);
 };
 
 #endif
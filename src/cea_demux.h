@@ -16,34 +16,130 @@
  */
 typedef struct {
 	int cc_count;        /* Number of 3-byte triplets written to cc_out (0 = none) */
-	int reorder_window;  /* -1 = no update; >= 0 = stream-detected reorder window */
+	int reorder_window;  /* -1 = no update; >= 0 = stream-detected reorder window.
+	                      * H.264/HEVC report it when an SPS is new or has changed. */
+	int reorder_exact;   /* 1 = reorder_window is signalled by the stream (SPS VUI,
+	                      * HEVC SPS, or a profile without B-frames), 0 = a guess */
 } cea_demux_result;
 
+/* NAL unit syntax handled by the shared H.264/HEVC demuxer */
+typedef enum {
+	CEA_NAL_H264,
+	CEA_NAL_HEVC,
+} cea_nal_format;
+
+/*
+ * SPS units seen so far, indexed by sps id. Streams repeat the SPS at
+ * every IDR/IRAP picture; a unit whose size and hash match the cached
+ * entry is not parsed again, as the window it gave is already in effect.
+ */
+#define CEA_MAX_SPS 32
+
+typedef struct {
+	struct {
+		uint32_t hash;    /* FNV-1a of the NAL bytes */
+		int size;         /* NAL size in bytes, 0 = empty slot */
+	} sps[CEA_MAX_SPS];
+} cea_sps_cache;
+
+void cea_demux_sps_cache_init(cea_sps_cache *cache);
+
 /*
- * Extract cc_data from an H.264 packet. Handles Annex B and AVCC formats.
+ * Extract cc_data from an H.264 or HEVC packet: A/53 GA94 cc_data from SEI
+ * NAL units (H.264 type 6, HEVC prefix SEI type 39), and the reorder
+ * window from SPS NAL units. NAL units are read in place.
  *
- * is_avcc:          1 for AVCC (length-prefixed NALs), 0 for Annex B
- * nal_length_size:  in/out -- 0 triggers auto-detection for AVCC, then cached
+ * fmt:              NAL syntax of the stream
+ * length_prefixed:  1 for AVCC/hvcC (length-prefixed NALs), 0 for Annex B
+ * nal_length_size:  in/out -- 0 triggers auto-detection for length-prefixed
+ *                   packets, then cached
+ * stop_at_vcl:      1 to stop at the first coded slice NAL (SEI and SPS
+ *                   precede it in a conforming access unit), 0 to walk
+ *                   the whole packet
+ * sps_cache:        SPS units seen so far (NULL to parse every SPS)
  * data/size:        raw packet data
  * cc_out:           output buffer, must hold at least 93 bytes (31*3)
  */
-cea_demux_result cea_demux_h264_extract_cc(int is_avcc, int *nal_length_size,
-                                           const uint8_t *data, int size,
-                                           uint8_t *cc_out);
+cea_demux_result cea_demux_nal_extract_cc(cea_nal_format fmt, int length_prefixed,
+                                          int *nal_length_size, int stop_at_vcl,
+                                          cea_sps_cache *sps_cache,
+                                          const uint8_t *data, int size,
+                                          uint8_t *cc_out);
 
 /*
- * Extract cc_data from an MPEG-2 video packet.
+ * Extract cc_data from an AV1 packet (a temporal unit of OBUs with size
+ * fields, as stored in MP4/MKV/WebM). cc_data comes from ITU-T T.35
+ * metadata OBUs; other OBUs, tile groups included, are skipped by size
+ * without reading their payload.
  *
  * data/size: raw packet data
  * cc_out:    output buffer, must hold at least 93 bytes (31*3)
  */
+cea_demux_result cea_demux_av1_extract_cc(const uint8_t *data, int size, uint8_t *cc_out);
+
+/*
+ * Extract cc_data from an MPEG-2 video packet.
+ *
+ * data/size:     raw packet data
+ * stop_at_slice: 1 to stop at the first slice start code after the picture
+ *                header (the picture's user data precedes it), 0 to walk
+ *                the whole packet
+ * cc_out:        output buffer, must hold at least 93 bytes (31*3)
+ */
 cea_demux_result cea_demux_mpeg2_extract_cc(const uint8_t *data, int size,
-                                            uint8_t *cc_out);
+                                            int stop_at_slice, uint8_t *cc_out);
 
 /*
  * Parse H.264 extradata (Annex B or AVCC format) for max_num_reorder_frames.
  * Returns the value (>= 0) on success, or -1 if not found/parse error.
+ * exact: set to 1 if the value is signalled rather than guessed.
+ */
+int cea_demux_h264_parse_extradata_reorder(const uint8_t *extradata, int size, int *exact);
+
+/*
+ * Parse HEVC extradata (Annex B or hvcC format) for sps_max_num_reorder_pics.
+ * Returns the value (>= 0) on success, or -1 if not found/parse error.
+ * nal_length_size: set to the hvcC NAL length size, 0 if not hvcC.
+ */
+int cea_demux_hevc_parse_extradata_reorder(const uint8_t *extradata, int size,
+                                           int *nal_length_size);
+
+/*
+ * Codec hooks used by cea_demux_nal_extract_cc(). nal/nal_len is a whole
+ * NAL unit, header included, still escaped.
+ *
+ * *_sps_id:    seq_parameter_set_id, or -1 on parse error
+ * *_parse_sps: reorder window (>= 0), or -1 on parse error; *exact as above
+ */
+int cea_demux_h264_sps_id(const uint8_t *nal, int nal_len);
+int cea_demux_h264_parse_sps(const uint8_t *nal, int nal_len, int *exact);
+int cea_demux_hevc_sps_id(const uint8_t *nal, int nal_len);
+int cea_demux_hevc_parse_sps(const uint8_t *nal, int nal_len, int *exact);
+
+/*
+ * Check the 10-byte ITU-T T.35 header that precedes A/53 cc_data:
+ * country 0xB5, provider 0x0031, "GA94", user_data_type_code 3, cc flags
+ * and em_data. Returns cc_count, or 0 if p is not cc_data.
+ */
+int cea_demux_t35_cc_count(const uint8_t *p);
+
+/*
+ * Find the next Annex B NAL unit at or after *pos.
+ * Sets nal_start/nal_end (a trailing zero that belongs to a following
+ * 4-byte start code is excluded) and advances *pos to the next start
+ * code. Returns 0 when there are no more NAL units, or when stop_at_vcl
+ * is set and the next NAL unit is a coded slice, so its payload is
+ * never scanned.
+ */
+int cea_demux_annexb_next_nal(cea_nal_format fmt, const uint8_t *data, int size,
+                              int stop_at_vcl, int *pos, int *nal_start, int *nal_end);
+
+/*
+ * Find the next 00 00 01 start code prefix in data[pos..size). A 4-byte
+ * start code (00 00 00 01) is reported at its last three bytes.
+ * Returns the offset of the prefix, or size if there is none.
+ * Uses SSE2/AVX2 when the CPU has them, with a scalar fallback.
  */
-int cea_demux_h264_parse_extradata_reorder(const uint8_t *extradata, int size);
+int cea_demux_find_start_code(const uint8_t *data, int pos, int size);
 
 #endif /* CEA_DEMUX_H */
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#include "cea_demux.h"
+
+#include <string.h>
+
+#define AV1_OBU_METADATA 5
+#define AV1_METADATA_TYPE_ITUT_T35 4
+
+/* ------------------------------------------------------------------ */
+/* Read an unsigned leb128 value (at most 8 bytes) at *pos.             */
+/* Returns 0 and advances *pos on success, -1 if the data runs out.     */
+/* ------------------------------------------------------------------ */
+static int read_leb128(const uint8_t *data, int size, int *pos, uint64_t *value)
+{
+	uint64_t v = 0;
+	for (int i = 0; i < 8; i++) {
+		if (*pos >= size)
+			return -1;
+		uint8_t b = data[(*pos)++];
+		v |= (uint64_t)(b & 0x7F) << (i * 7);
+		if (!(b & 0x80)) {
+			*value = v;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/* ------------------------------------------------------------------ */
+/* Parse a metadata OBU payload for ITU-T T.35 A/53 cc_data.           */
+/* Returns cc_count, fills cc_out.                                      */
+/* ------------------------------------------------------------------ */
+static int parse_av1_metadata_for_cc(const uint8_t *obu, int obu_len, uint8_t *cc_out)
+{
+	int pos = 0;
+	uint64_t metadata_type;
+	if (read_leb128(obu, obu_len, &pos, &metadata_type) < 0)
+		return 0;
+	if (metadata_type != AV1_METADATA_TYPE_ITUT_T35)
+		return 0;
+
+	/* itu_t_t35_country_code onwards has the same layout as the H.264 SEI
+	 * registered user data payload */
+	const uint8_t *p = obu + pos;
+	int len = obu_len - pos;
+	if (len < 10)
+		return 0;
+	int count = cea_demux_t35_cc_count(p);
+	if (count == 0 || len < 10 + count * 3)
+		return 0;
+
+	memcpy(cc_out, p + 10, count * 3);
+	return count;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public entry point: extract cc_data from AV1 packet.                 */
+/* ------------------------------------------------------------------ */
+cea_demux_result cea_demux_av1_extract_cc(const uint8_t *data, int size, uint8_t *cc_out)
+{
+	cea_demux_result result = {0, -1, 0};
+	int pos = 0;
+
+	while (pos < size && result.cc_count == 0) {
+		/* obu_header: forbidden_bit(1) obu_type(4) obu_extension_flag(1)
+		 *             obu_has_size_field(1) obu_reserved_1bit(1) */
+		uint8_t header = data[pos];
+		if (header & 0x80)
+			break;
+		int obu_type = (header >> 3) & 0x0F;
+		int has_extension = (header >> 2) & 1;
+		int has_size = (header >> 1) & 1;
+		pos += 1 + has_extension;
+
+		/* An OBU without a size field runs to the end of the packet */
+		uint64_t obu_size = (uint64_t)(size - pos);
+		if (has_size && read_leb128(data, size, &pos, &obu_size) < 0)
+			break;
+		if (pos > size || obu_size > (uint64_t)(size - pos))
+			break;
+
+		if (obu_type == AV1_OBU_METADATA)
+			result.cc_count = parse_av1_metadata_for_cc(data + pos, (int)obu_size, cc_out);
+
+		/* Tile groups, frames and everything else: skip by size */
+		pos += (int)obu_size;
+	}
+
+	return result;
+}
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#include "cea_demux_bitreader.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Number of leading zero bits of a non-zero 64-bit value */
+static int clz64(uint64_t v)
+{
+#if defined(__GNUC__)
+	return __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long idx;
+	_BitScanReverse64(&idx, v);
+	return 63 - (int)idx;
+#else
+	int n = 0;
+	while (!(v & 0x8000000000000000ULL)) {
+		v <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+void cea_bitreader_init(cea_bitreader *br, const uint8_t *data, int size)
+{
+	br->data = data;
+	br->size = size > 0 ? size : 0;
+	br->pos = 0;
+	br->zeros = 0;
+	br->cache = 0;
+	br->bits = 0;
+	br->consumed = 0;
+	br->failed = 0;
+}
+
+/* Top the cache up to at least 57 bits, dropping emulation prevention bytes */
+static void refill(cea_bitreader *br)
+{
+	while (br->bits <= 56 && br->pos < br->size) {
+		uint8_t b = br->data[br->pos++];
+		if (br->zeros >= 2 && b == 0x03) {
+			br->zeros = 0;
+			continue;
+		}
+		br->zeros = b ? 0 : br->zeros + 1;
+		br->cache |= (uint64_t)b << (56 - br->bits);
+		br->bits += 8;
+	}
+}
+
+static void consume(cea_bitreader *br, int n)
+{
+	br->cache = n < 64 ? br->cache << n : 0;
+	br->bits -= n;
+	br->consumed += n;
+}
+
+int cea_bitreader_read_bits(cea_bitreader *br, int n)
+{
+	if (br->failed || n < 0 || n > 31)
+		return -1;
+	if (n == 0)
+		return 0;
+	if (br->bits < n) {
+		refill(br);
+		if (br->bits < n) {
+			br->failed = 1;
+			return -1;
+		}
+	}
+	int val = (int)(br->cache >> (64 - n));
+	consume(br, n);
+	return val;
+}
+
+void cea_bitreader_skip_bits(cea_bitreader *br, int n)
+{
+	while (n > 0 && !br->failed) {
+		if (br->bits == 0) {
+			refill(br);
+			if (br->bits == 0) {
+				br->failed = 1;
+				return;
+			}
+		}
+		int step = n < br->bits ? n : br->bits;
+		consume(br, step);
+		n -= step;
+	}
+}
+
+int cea_bitreader_read_ue(cea_bitreader *br)
+{
+	if (br->failed)
+		return -1;
+
+	/* Any code with up to 20 leading zeros fits in 41 bits; after a refill
+	 * the cache only holds fewer if the data is nearly used up. */
+	if (br->bits < 41)
+		refill(br);
+	if (br->cache == 0) {
+		br->failed = 1;
+		return -1;
+	}
+	int leading_zeros = clz64(br->cache);
+	int len = 2 * leading_zeros + 1;
+	if (leading_zeros > 20 || len > br->bits) {
+		br->failed = 1;
+		return -1;
+	}
+	uint64_t code = br->cache >> (64 - len);
+	consume(br, len);
+	return (int)(code - 1);
+}
+
+int64_t cea_bitreader_bits_left(const cea_bitreader *br)
+{
+	if (br->failed)
+		return 0;
+	return br->bits + (int64_t)(br->size - br->pos) * 8;
+}
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#ifndef CEA_DEMUX_BITREADER_H
+#define CEA_DEMUX_BITREADER_H
+
+#include <stdint.h>
+
+/*
+ * Bit reader over a NAL unit payload. Emulation prevention bytes
+ * (00 00 03 -> 00 00) are dropped as bytes are loaded into a 64-bit
+ * cache, so the NAL is read in place without an unescaped copy.
+ * Reads past the end fail with -1 and leave the reader failed.
+ */
+typedef struct cea_bitreader
+{
+	const uint8_t *data;
+	int size;
+	int pos;        /* next byte of data to load into the cache */
+	int zeros;      /* zero bytes loaded in a row, for EPB detection */
+	uint64_t cache; /* unread bits, MSB first */
+	int bits;       /* number of valid bits in cache */
+	int64_t consumed; /* unescaped bits read or skipped so far */
+	int failed;
+} cea_bitreader;
+
+void cea_bitreader_init(cea_bitreader *br, const uint8_t *data, int size);
+
+/* Read n bits (0-31). Returns the value, or -1 if the data ran out. */
+int cea_bitreader_read_bits(cea_bitreader *br, int n);
+
+/* Skip n bits. Running past the end makes later reads fail. */
+void cea_bitreader_skip_bits(cea_bitreader *br, int n);
+
+/* Read an unsigned exp-Golomb value. Returns it, or -1 on error
+ * (data ran out, or more than 20 leading zero bits). */
+int cea_bitreader_read_ue(cea_bitreader *br);
+
+/* Upper bound of the unescaped bits left (EPBs not yet loaded are counted) */
+int64_t cea_bitreader_bits_left(const cea_bitreader *br);
+
+#endif /* CEA_DEMUX_BITREADER_H */
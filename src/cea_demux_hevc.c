@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#include "cea_demux.h"
+#include "cea_demux_bitreader.h"
+
+/* ------------------------------------------------------------------ */
+/* Skip HEVC profile_tier_level(1, max_sub_layers_minus1) in the SPS.   */
+/* Returns 0 on success, -1 on error.                                   */
+/* ------------------------------------------------------------------ */
+static int skip_profile_tier_level(cea_bitreader *br, int max_sub_layers_minus1)
+{
+	/* general_profile_space .. general_inbld/reserved flag (88 bits),
+	 * general_level_idc (8 bits) */
+	cea_bitreader_skip_bits(br, 88 + 8);
+
+	int profile_present[8], level_present[8];
+	for (int i = 0; i < max_sub_layers_minus1; i++) {
+		profile_present[i] = cea_bitreader_read_bits(br, 1);
+		level_present[i] = cea_bitreader_read_bits(br, 1);
+	}
+	if (max_sub_layers_minus1 > 0)
+		cea_bitreader_skip_bits(br, 2 * (8 - max_sub_layers_minus1)); /* reserved_zero_2bits */
+	for (int i = 0; i < max_sub_layers_minus1; i++) {
+		if (profile_present[i])
+			cea_bitreader_skip_bits(br, 88);
+		if (level_present[i])
+			cea_bitreader_skip_bits(br, 8);
+	}
+	return br->failed ? -1 : 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Read an HEVC SPS up to and including sps_seq_parameter_set_id.      */
+/* Returns the id, or -1 on error.                                      */
+/* ------------------------------------------------------------------ */
+static int read_sps_header(cea_bitreader *br, const uint8_t *nal, int nal_len,
+                           int *max_sub_layers_minus1)
+{
+	cea_bitreader_init(br, nal, nal_len);
+
+	/* NAL header (2 bytes) */
+	cea_bitreader_skip_bits(br, 16);
+
+	cea_bitreader_skip_bits(br, 4); /* sps_video_parameter_set_id */
+	*max_sub_layers_minus1 = cea_bitreader_read_bits(br, 3);
+	if (*max_sub_layers_minus1 < 0 || *max_sub_layers_minus1 > 6)
+		return -1;
+	cea_bitreader_skip_bits(br, 1); /* sps_temporal_id_nesting_flag */
+
+	if (skip_profile_tier_level(br, *max_sub_layers_minus1) < 0)
+		return -1;
+
+	return cea_bitreader_read_ue(br);
+}
+
+int cea_demux_hevc_sps_id(const uint8_t *nal, int nal_len)
+{
+	cea_bitreader br;
+	int max_sub_layers_minus1;
+	return read_sps_header(&br, nal, nal_len, &max_sub_layers_minus1);
+}
+
+/* ------------------------------------------------------------------ */
+/* Parse HEVC SPS NAL to extract sps_max_num_reorder_pics of the       */
+/* highest sub-layer. HEVC always signals it, so *exact is set to 1.   */
+/* Returns >= 0 on success, -1 on parse error.                          */
+/* ------------------------------------------------------------------ */
+int cea_demux_hevc_parse_sps(const uint8_t *nal, int nal_len, int *exact)
+{
+	cea_bitreader br;
+	int max_sub_layers_minus1;
+
+	*exact = 0;
+	if (read_sps_header(&br, nal, nal_len, &max_sub_layers_minus1) < 0)
+		return -1;
+
+	int chroma_format_idc = cea_bitreader_read_ue(&br);
+	if (chroma_format_idc < 0) return -1;
+	if (chroma_format_idc == 3)
+		cea_bitreader_skip_bits(&br, 1); /* separate_colour_plane_flag */
+	if (cea_bitreader_read_ue(&br) < 0) return -1; /* pic_width_in_luma_samples */
+	if (cea_bitreader_read_ue(&br) < 0) return -1; /* pic_height_in_luma_samples */
+
+	int conformance_window = cea_bitreader_read_bits(&br, 1);
+	if (conformance_window < 0) return -1;
+	if (conformance_window) {
+		for (int i = 0; i < 4; i++) {
+			if (cea_bitreader_read_ue(&br) < 0) return -1;
+		}
+	}
+
+	if (cea_bitreader_read_ue(&br) < 0) return -1; /* bit_depth_luma_minus8 */
+	if (cea_bitreader_read_ue(&br) < 0) return -1; /* bit_depth_chroma_minus8 */
+	if (cea_bitreader_read_ue(&br) < 0) return -1; /* log2_max_pic_order_cnt_lsb_minus4 */
+
+	/* Without sub_layer_ordering_info only the highest sub-layer is coded */
+	int ordering_info_present = cea_bitreader_read_bits(&br, 1);
+	if (ordering_info_present < 0) return -1;
+
+	int max_reorder = -1;
+	for (int i = ordering_info_present ? 0 : max_sub_layers_minus1; i <= max_sub_layers_minus1; i++) {
+		if (cea_bitreader_read_ue(&br) < 0) return -1; /* sps_max_dec_pic_buffering_minus1 */
+		max_reorder = cea_bitreader_read_ue(&br);
+		if (max_reorder < 0) return -1;
+		if (cea_bitreader_read_ue(&br) < 0) return -1; /* sps_max_latency_increase_plus1 */
+	}
+
+	*exact = 1;
+	return max_reorder;
+}
+
+/* ------------------------------------------------------------------ */
+/* Parse HEVC extradata for sps_max_num_reorder_pics.                   */
+/* Handles both Annex B (start-code delimited) and hvcC (ISO 14496-15) */
+/* formats. Returns >= 0 on success, -1 on failure.                     */
+/* ------------------------------------------------------------------ */
+int cea_demux_hevc_parse_extradata_reorder(const uint8_t *extradata, int size,
+                                           int *nal_length_size)
+{
+	int exact;
+
+	*nal_length_size = 0;
+	if (!extradata || size < 4)
+		return -1;
+
+	/* hvcC format: starts with configurationVersion == 1 */
+	if (extradata[0] == 1 && size >= 23) {
+		/* hvcC header: version(1) + profile/tier/level and stream info(20)
+		 * + [..., lengthSizeMinusOne(2 bits)](1) + numOfArrays(1), then per
+		 * array: [completeness(1) + reserved(1) + NAL_unit_type(6)](1)
+		 * + numNalus(2) + [nalUnitLength(2) + NAL]... */
+		*nal_length_size = (extradata[21] & 0x03) + 1;
+		int num_arrays = extradata[22];
+		int pos = 23;
+		for (int a = 0; a < num_arrays; a++) {
+			if (pos + 3 > size) return -1;
+			int type = extradata[pos] & 0x3F;
+			int num_nalus = (extradata[pos + 1] << 8) | extradata[pos + 2];
+			pos += 3;
+			for (int i = 0; i < num_nalus; i++) {
+				if (pos + 2 > size) return -1;
+				int nal_len = (extradata[pos] << 8) | extradata[pos + 1];
+				pos += 2;
+				if (pos + nal_len > size) return -1;
+				if (type == 33) {
+					int mr = cea_demux_hevc_parse_sps(extradata + pos, nal_len, &exact);
+					if (mr >= 0) return mr;
+				}
+				pos += nal_len;
+			}
+		}
+		return -1;
+	}
+
+	/* Annex B format: scan for start codes, find NAL type 33 (SPS) */
+	int pos = 0, nal_start, nal_end;
+	while (cea_demux_annexb_next_nal(CEA_NAL_HEVC, extradata, size, 0, &pos, &nal_start, &nal_end)) {
+		uint8_t nal_type = (extradata[nal_start] >> 1) & 0x3F;
+		if (nal_type == 33) {
+			int mr = cea_demux_hevc_parse_sps(extradata + nal_start, nal_end - nal_start, &exact);
+			if (mr >= 0) return mr;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,314 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#include "cea_demux.h"
+#include "cea_demux_bitreader.h"
+
+#include <string.h>
+
+/* ------------------------------------------------------------------ */
+/* NAL header layout. H.264: 1 byte, type in bits 4-0, coded slices    */
+/* are types 1-5. HEVC: 2 bytes, type in bits 6-1 of the first, coded */
+/* slices are types 0-31.                                               */
+/* ------------------------------------------------------------------ */
+#define H264_NAL_SEI 6
+#define H264_NAL_SPS 7
+#define HEVC_NAL_SPS 33
+#define HEVC_NAL_PREFIX_SEI 39
+
+static int nal_header_size(cea_nal_format fmt)
+{
+	return fmt == CEA_NAL_HEVC ? 2 : 1;
+}
+
+static int nal_type(cea_nal_format fmt, uint8_t first_byte)
+{
+	return fmt == CEA_NAL_HEVC ? (first_byte >> 1) & 0x3F : first_byte & 0x1F;
+}
+
+/* Coded slice NAL units. SEI and SPS must precede the first one in an */
+/* access unit, so nothing after it is of interest.                    */
+static int nal_is_vcl(cea_nal_format fmt, int type)
+{
+	return fmt == CEA_NAL_HEVC ? type <= 31 : (type >= 1 && type <= 5);
+}
+
+/* ------------------------------------------------------------------ */
+/* ITU-T T.35 header of A/53 cc_data, shared by SEI and AV1 metadata.  */
+/* ------------------------------------------------------------------ */
+int cea_demux_t35_cc_count(const uint8_t *p)
+{
+	/* Country code: 0xB5 (United States) */
+	if (p[0] != 0xB5)
+		return 0;
+
+	/* Provider code: 0x0031 (ATSC) */
+	uint16_t provider = (p[1] << 8) | p[2];
+	if (provider != 0x0031)
+		return 0;
+
+	/* GA94 identifier: "GA94" = 0x47413934 */
+	if (p[3] != 0x47 || p[4] != 0x41 || p[5] != 0x39 || p[6] != 0x34)
+		return 0;
+
+	/* user_data_type_code == 0x03 (cc_data) */
+	if (p[7] != 0x03)
+		return 0;
+
+	/* p[8]: process_em_data_flag(1) | process_cc_data_flag(1) |
+	 *       additional_data_flag(1) | cc_count(5) */
+	int process_cc_data_flag = (p[8] >> 6) & 1;
+	int count = p[8] & 0x1F;
+
+	if (!process_cc_data_flag)
+		return 0;
+
+	/* p[9] = em_data (skip) */
+	return count;
+}
+
+/* ------------------------------------------------------------------ */
+/* Parse a single SEI NAL unit for ATSC closed-caption data            */
+/* (ITU-T A/53 Part 4, payload type 4 = registered user data). H.264   */
+/* and HEVC share the SEI message syntax after the NAL header.          */
+/*                                                                      */
+/* cc_out must have room for at least 93 bytes (31 triplets max).       */
+/* Returns cc_count (number of 3-byte triplets written), or 0.          */
+/* ------------------------------------------------------------------ */
+static int parse_sei_for_cc(cea_nal_format fmt, const uint8_t *nal, int nal_len, uint8_t *cc_out)
+{
+	cea_bitreader br;
+	cea_bitreader_init(&br, nal, nal_len);
+
+	/* Skip the NAL header */
+	int header_size = nal_header_size(fmt);
+	if (nal_len < header_size + 1)
+		return 0;
+	cea_bitreader_skip_bits(&br, header_size * 8);
+
+	/* Parse SEI messages, stopping before the rbsp trailing byte */
+	while (cea_bitreader_bits_left(&br) > 8) {
+		/* Read payload type (variable length) */
+		int payload_type = 0;
+		int b;
+		while ((b = cea_bitreader_read_bits(&br, 8)) == 0xFF)
+			payload_type += 255;
+		if (b < 0)
+			break;
+		payload_type += b;
+
+		/* Read payload size (variable length) */
+		int payload_size = 0;
+		while ((b = cea_bitreader_read_bits(&br, 8)) == 0xFF)
+			payload_size += 255;
+		if (b < 0)
+			break;
+		payload_size += b;
+
+		if ((int64_t)payload_size * 8 > cea_bitreader_bits_left(&br))
+			break;
+		int64_t payload_end = br.consumed + (int64_t)payload_size * 8;
+
+		/* payload_type 4 = user_data_registered_itu_t_t35 */
+		if (payload_type == 4 && payload_size >= 10) {
+			uint8_t p[10];
+			for (int i = 0; i < 10; i++)
+				p[i] = (uint8_t)cea_bitreader_read_bits(&br, 8);
+			if (br.failed)
+				break;
+
+			int count = cea_demux_t35_cc_count(p);
+			if (count == 0)
+				goto next_sei;
+
+			/* cc_data follows, each triplet is 3 bytes */
+			if (payload_size < 10 + count * 3)
+				goto next_sei;
+
+			for (int i = 0; i < count * 3; i++)
+				cc_out[i] = (uint8_t)cea_bitreader_read_bits(&br, 8);
+			/* The whole payload has to be present, not just the cc_data */
+			cea_bitreader_skip_bits(&br, (int)(payload_end - br.consumed));
+			return br.failed ? 0 : count;
+		}
+
+next_sei:
+		cea_bitreader_skip_bits(&br, (int)(payload_end - br.consumed));
+	}
+
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* SPS cache                                                            */
+/* ------------------------------------------------------------------ */
+void cea_demux_sps_cache_init(cea_sps_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+}
+
+static uint32_t fnv1a(const uint8_t *data, int size)
+{
+	uint32_t h = 2166136261u;
+	for (int i = 0; i < size; i++) {
+		h ^= data[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static int parse_sps(cea_nal_format fmt, const uint8_t *nal, int nal_len, int *exact)
+{
+	if (fmt == CEA_NAL_HEVC)
+		return cea_demux_hevc_parse_sps(nal, nal_len, exact);
+	return cea_demux_h264_parse_sps(nal, nal_len, exact);
+}
+
+/* Returns the reorder window if this SPS is new or differs from the
+ * cached one with the same id, or -1 if it is unchanged or unparseable. */
+static int sps_cache_update(cea_nal_format fmt, cea_sps_cache *cache,
+                            const uint8_t *nal, int nal_len, int *exact)
+{
+	if (!cache)
+		return parse_sps(fmt, nal, nal_len, exact);
+
+	int sps_id = fmt == CEA_NAL_HEVC ? cea_demux_hevc_sps_id(nal, nal_len)
+	                                 : cea_demux_h264_sps_id(nal, nal_len);
+	if (sps_id < 0 || sps_id >= CEA_MAX_SPS)
+		return parse_sps(fmt, nal, nal_len, exact);
+
+	uint32_t hash = fnv1a(nal, nal_len);
+	if (cache->sps[sps_id].size == nal_len && cache->sps[sps_id].hash == hash)
+		return -1;
+
+	int mr = parse_sps(fmt, nal, nal_len, exact);
+	cache->sps[sps_id].hash = hash;
+	cache->sps[sps_id].size = nal_len;
+	return mr;
+}
+
+/* ------------------------------------------------------------------ */
+/* Annex B NAL unit iteration                                           */
+/* ------------------------------------------------------------------ */
+int cea_demux_annexb_next_nal(cea_nal_format fmt, const uint8_t *data, int size,
+                              int stop_at_vcl, int *pos, int *nal_start, int *nal_end)
+{
+	int start = cea_demux_find_start_code(data, *pos, size) + 3;
+	if (start >= size)
+		return 0;
+	if (stop_at_vcl && nal_is_vcl(fmt, nal_type(fmt, data[start])))
+		return 0;
+
+	int next = cea_demux_find_start_code(data, start + 1, size);
+	int end = next;
+	if (end < size && end - 1 > start && data[end - 1] == 0x00)
+		end--;
+
+	*nal_start = start;
+	*nal_end = end;
+	*pos = next;
+	return 1;
+}
+
+/* ------------------------------------------------------------------ */
+/* Auto-detect the NAL length size of length-prefixed packets.          */
+/* Tries 4, 2, 1 in order; validates with length + NAL header checks.  */
+/* Returns detected size, or 4 as fallback.                             */
+/* ------------------------------------------------------------------ */
+static int auto_detect_nal_length_size(cea_nal_format fmt, const uint8_t *data, int size)
+{
+	int candidates[] = {4, 2, 1};
+	for (int c = 0; c < 3; c++) {
+		int nls = candidates[c];
+		if (nls > size)
+			continue;
+
+		uint32_t nal_len = 0;
+		for (int i = 0; i < nls; i++)
+			nal_len = (nal_len << 8) | data[i];
+
+		if (nal_len < (uint32_t)nal_header_size(fmt) || nal_len > (uint32_t)(size - nls))
+			continue;
+
+		/* Validate the NAL header: forbidden_zero_bit must be 0. H.264 type
+		 * 0 is unspecified; HEVC nuh_temporal_id_plus1 must be non-zero. */
+		uint8_t first_byte = data[nls];
+		if (first_byte & 0x80)
+			continue;
+		if (fmt == CEA_NAL_HEVC ? (data[nls + 1] & 0x07) == 0 : nal_type(fmt, first_byte) == 0)
+			continue;
+
+		return nls;
+	}
+	return 4; /* fallback */
+}
+
+/* Handle one NAL unit of a packet: SPS updates the reorder window, SEI
+ * may carry cc_data. Only the first of each in a packet is used. */
+static void handle_nal(cea_nal_format fmt, cea_sps_cache *sps_cache,
+                       const uint8_t *nal, int nal_len, uint8_t *cc_out,
+                       cea_demux_result *result, int *sps_exact)
+{
+	int type = nal_type(fmt, nal[0]);
+	int is_sps = fmt == CEA_NAL_HEVC ? type == HEVC_NAL_SPS : type == H264_NAL_SPS;
+	int is_sei = fmt == CEA_NAL_HEVC ? type == HEVC_NAL_PREFIX_SEI : type == H264_NAL_SEI;
+
+	if (is_sps && result->reorder_window < 0) {
+		int mr = sps_cache_update(fmt, sps_cache, nal, nal_len, sps_exact);
+		if (mr >= 0) result->reorder_window = mr;
+	}
+	if (is_sei && result->cc_count == 0) {
+		result->cc_count = parse_sei_for_cc(fmt, nal, nal_len, cc_out);
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* Public entry point: extract cc_data from an H.264 or HEVC packet.    */
+/* ------------------------------------------------------------------ */
+cea_demux_result cea_demux_nal_extract_cc(cea_nal_format fmt, int length_prefixed,
+                                          int *nal_length_size, int stop_at_vcl,
+                                          cea_sps_cache *sps_cache,
+                                          const uint8_t *data, int size,
+                                          uint8_t *cc_out)
+{
+	cea_demux_result result = {0, -1, 0};
+	int sps_exact = 0;
+
+	/* Auto-detect nal_length_size for AVCC/hvcC on first call */
+	if (length_prefixed && *nal_length_size == 0)
+		*nal_length_size = auto_detect_nal_length_size(fmt, data, size);
+
+	if (length_prefixed) {
+		/* AVCC/hvcC format: length-prefixed NAL units */
+		int nls = *nal_length_size;
+		int pos = 0;
+		while (pos + nls <= size) {
+			uint32_t nal_len = 0;
+			for (int i = 0; i < nls; i++)
+				nal_len = (nal_len << 8) | data[pos + i];
+			pos += nls;
+
+			if (nal_len == 0 || nal_len > (uint32_t)(size - pos))
+				break;
+
+			if (stop_at_vcl && nal_is_vcl(fmt, nal_type(fmt, data[pos])))
+				break;
+
+			handle_nal(fmt, sps_cache, data + pos, (int)nal_len, cc_out, &result, &sps_exact);
+			pos += (int)nal_len;
+		}
+	} else {
+		/* Annex B: NAL units delimited by start codes (00 00 01 or 00 00 00 01) */
+		int pos = 0, nal_start, nal_end;
+		while (cea_demux_annexb_next_nal(fmt, data, size, stop_at_vcl, &pos, &nal_start, &nal_end))
+			handle_nal(fmt, sps_cache, data + nal_start, nal_end - nal_start, cc_out, &result, &sps_exact);
+	}
+
+	result.reorder_exact = result.reorder_window >= 0 && sps_exact;
+	return result;
+}
@@ -0,0 +1,124 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * libcea — Programmatic closed-caption extraction (EIA-608 / CEA-708).
+ * Based on CCExtractor: https://github.com/CCExtractor/ccextractor
+ *
+ * Copyright (C) libcea, 2026–present.
+ * Copyright (C) CCExtractor <https://github.com/CCExtractor/ccextractor>, <2026.
+ */
+
+#include "cea_demux.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CEA_SCAN_X86_DISPATCH 1
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define CEA_SCAN_SSE2_ONLY 1
+#include <emmintrin.h>
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Scalar scan. Looks at the third byte of each candidate first: if it */
+/* is above 1, no start code can begin at any of the three positions.  */
+/* ------------------------------------------------------------------ */
+static int find_start_code_scalar(const uint8_t *data, int pos, int size)
+{
+	int i = pos;
+	while (i + 2 < size) {
+		if (data[i + 2] > 1)
+			i += 3;
+		else if (data[i + 1])
+			i += 2;
+		else if (data[i] || data[i + 2] != 1)
+			i++;
+		else
+			return i;
+	}
+	return size;
+}
+
+#if defined(CEA_SCAN_X86_DISPATCH) || defined(CEA_SCAN_SSE2_ONLY)
+
+/* ------------------------------------------------------------------ */
+/* SSE2 scan: compare 16 candidate positions at once against 00/00/01  */
+/* using three overlapping loads.                                      */
+/* ------------------------------------------------------------------ */
+#ifdef CEA_SCAN_X86_DISPATCH
+__attribute__((target("sse2")))
+#endif
+static int find_start_code_sse2(const uint8_t *data, int pos, int size)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	int i = pos;
+
+	for (; i + 18 <= size; i += 16) {
+		__m128i b0 = _mm_loadu_si128((const __m128i *)(data + i));
+		__m128i b1 = _mm_loadu_si128((const __m128i *)(data + i + 1));
+		__m128i b2 = _mm_loadu_si128((const __m128i *)(data + i + 2));
+		__m128i hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+		                            _mm_cmpeq_epi8(b2, one));
+		unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+		if (mask) {
+#ifdef CEA_SCAN_X86_DISPATCH
+			return i + __builtin_ctz(mask);
+#else
+			unsigned long bit;
+			_BitScanForward(&bit, mask);
+			return i + (int)bit;
+#endif
+		}
+	}
+	return find_start_code_scalar(data, i, size);
+}
+
+#endif
+
+#ifdef CEA_SCAN_X86_DISPATCH
+
+/* ------------------------------------------------------------------ */
+/* AVX2 scan: same as SSE2 with 32 candidate positions per step.       */
+/* ------------------------------------------------------------------ */
+__attribute__((target("avx2")))
+static int find_start_code_avx2(const uint8_t *data, int pos, int size)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi8(1);
+	int i = pos;
+
+	for (; i + 34 <= size; i += 32) {
+		__m256i b0 = _mm256_loadu_si256((const __m256i *)(data + i));
+		__m256i b1 = _mm256_loadu_si256((const __m256i *)(data + i + 1));
+		__m256i b2 = _mm256_loadu_si256((const __m256i *)(data + i + 2));
+		__m256i hit = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)),
+		                               _mm256_cmpeq_epi8(b2, one));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+	return find_start_code_sse2(data, i, size);
+}
+
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Public entry point. The CPU check reads flags the compiler runtime  */
+/* fills in at startup, so selecting per call keeps this function free */
+/* of shared mutable state.                                            */
+/* ------------------------------------------------------------------ */
+int cea_demux_find_start_code(const uint8_t *data, int pos, int size)
+{
+	if (pos < 0)
+		pos = 0;
+	if (pos + 2 >= size)
+		return size;
+
+#if defined(CEA_SCAN_X86_DISPATCH)
+	if (__builtin_cpu_supports("avx2"))
+		return find_start_code_avx2(data, pos, size);
+	if (__builtin_cpu_supports("sse2"))
+		return find_start_code_sse2(data, pos, size);
+#elif defined(CEA_SCAN_SSE2_ONLY)
+	return find_start_code_sse2(data, pos, size);
+#endif
+	return find_start_code_scalar(data, pos, size);
+}
@@ -12,77 +12,97 @@
 #include <stdlib.h>
 #include <string.h>
 
-void dtvcc_process_data(struct dtvcc_ctx *dtvcc,
-			const unsigned char *data)
+/* Length of the current packet including its header, once known */
+static int dtvcc_packet_length(const dtvcc_ctx *dtvcc)
+{
+	int len = dtvcc->current_packet[0] & 0x3F; // 6 least significants bits
+	if (len == 0) // This is well defined in EIA-708; no magic.
+		return 128;
+	return len * 2;
+}
+
+void dtvcc_process_cc_data(struct dtvcc_ctx *dtvcc, const unsigned char *cc_data, int cc_count)
 {
 	/*
-	 * Note: the data has following format:
-	 * 1 byte for cc_valid
-	 * 1 byte for cc_type
-	 * 2 bytes for the actual data
+	 * cc_data holds cc_count triplets of one header byte
+	 * (marker bits, cc_valid, cc_type) and 2 bytes of data. Only valid
+	 * DTVCC triplets (cc_type 2 and 3) are looked at.
 	 */
 
 	if (!dtvcc->is_active && !dtvcc->report_enabled)
 		return;
 
-	unsigned char cc_valid = data[0];
-	unsigned char cc_type = data[1];
-
-	switch (cc_type)
+	int i = 0;
+	while (i < cc_count)
 	{
-		case 2:
-			dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_data: DTVCC Channel Packet Data\n");
-			if (cc_valid && dtvcc->is_current_packet_header_parsed)
-			{
-				if (dtvcc->current_packet_length + 2 > CEA_DTVCC_MAX_PACKET_LENGTH)
+		const unsigned char *t = cc_data + i * 3;
+		switch (t[0] & 7)
+		{
+			case 6: // cc_valid, cc_type 2
+				if (!dtvcc->is_current_packet_header_parsed)
 				{
-					dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_data: "
-										  "Warning: Legal packet size exceeded (1), data not added.\n");
+					i++;
+					break;
 				}
-				else
 				{
-					dtvcc->current_packet[dtvcc->current_packet_length++] = data[2];
-					dtvcc->current_packet[dtvcc->current_packet_length++] = data[3];
-					int len = dtvcc->current_packet[0] & 0x3F; // 6 least significants bits
-
-					if (len == 0) // This is well defined in EIA-708; no magic.
-						len = 128;
-					else
-						len = len * 2;
-					// Note that len here is the length including the header
-
+					/* Copy the run of packet data triplets up to the end
+					 * of the packet, then process it once */
+					int len = dtvcc_packet_length(dtvcc);
+					int pairs = (len - dtvcc->current_packet_length) / 2;
+					int room = (CEA_DTVCC_MAX_PACKET_LENGTH - dtvcc->current_packet_length) / 2;
+					unsigned char *dst = dtvcc->current_packet + dtvcc->current_packet_length;
+					int n = 0;
+
+					if (pairs < 1)
+						pairs = 1;
+					if (pairs > room)
+						pairs = room;
+					while (n < pairs && i < cc_count && (cc_data[i * 3] & 7) == 6)
+					{
+						dst[0] = cc_data[i * 3 + 1];
+						dst[1] = cc_data[i * 3 + 2];
+						dst += 2;
+						n++;
+						i++;
+					}
+					if (!n)
+					{
+						dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_cc_data: "
+											  "Warning: Legal packet size exceeded (1), data not added.\n");
+						i++;
+						break;
+					}
+					dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_cc_data: DTVCC Channel Packet Data (%d bytes)\n", n * 2);
+					dtvcc->current_packet_length += n * 2;
 					if (dtvcc->current_packet_length >= len)
 						dtvcc_process_current_packet(dtvcc, len);
 				}
-			}
-			break;
-		case 3:
-			dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_data: DTVCC Channel Packet Start\n");
-			if (cc_valid)
-			{
+				break;
+			case 7: // cc_valid, cc_type 3
+				dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_cc_data: DTVCC Channel Packet Start\n");
 				if (dtvcc->current_packet_length + 2 > CEA_DTVCC_MAX_PACKET_LENGTH)
 				{
-					dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_data: "
+					dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_cc_data: "
 										  "Warning: Legal packet size exceeded (2), data not added.\n");
 				}
 				else
 				{
 					if (dtvcc->is_current_packet_header_parsed)
 					{
-						dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_process_data: "
+						dbg_print(dtvcc->log, CEA_DMT_708, "[CEA-708] dtvcc_process_cc_data: "
 											  "Warning: Incorrect packet length specified. Packet will be skipped.\n");
 						dtvcc_clear_packet(dtvcc);
 					}
-					dtvcc->current_packet[dtvcc->current_packet_length++] = data[2];
-					dtvcc->current_packet[dtvcc->current_packet_length++] = data[3];
+					dtvcc->current_packet[dtvcc->current_packet_length++] = t[1];
+					dtvcc->current_packet[dtvcc->current_packet_length++] = t[2];
 					dtvcc->is_current_packet_header_parsed = 1;
 				}
-			}
-			break;
-		default:
-			fatal(CEA_COMMON_EXIT_BUG_BUG, "[CEA-708] dtvcc_process_data: "
-									      "shouldn't be here - cc_type: %d\n",
-						     cc_type);
+				i++;
+				break;
+			default: // EIA-608 or not valid
+				i++;
+				break;
+		}
 	}
 }
 
@@ -90,11 +110,11 @@ void dtvcc_process_data(struct dtvcc_ctx *dtvcc,
 
 dtvcc_ctx *dtvcc_init(struct cea_decoder_dtvcc_settings *opts)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] initializing dtvcc decoder\n");
+	dbg_print(opts->log, CEA_DMT_708, "[CEA-708] initializing dtvcc decoder\n");
 	dtvcc_ctx *ctx = (dtvcc_ctx *)malloc(sizeof(dtvcc_ctx));
 	if (!ctx)
 	{
-		fatal(EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_init");
+		fatal(opts->log, EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_init");
 		return NULL;
 	}
 
@@ -102,9 +122,17 @@ dtvcc_ctx *dtvcc_init(struct cea_decoder_dtvcc_settings *opts)
 	ctx->report->reset_count = 0;
 	ctx->is_active = 0;
 	ctx->report_enabled = 0;
-	ctx->active_services_count = opts->active_services_count;
-
-	memcpy(ctx->services_active, opts->services_enabled, CEA_DTVCC_MAX_SERVICES * sizeof(int));
+	// Active services get consecutive decoder slots, in service order
+	ctx->services_active = 0;
+	ctx->active_services_count = 0;
+	memset(ctx->service_slot, 0, sizeof(ctx->service_slot));
+	for (int i = 0; i < CEA_DTVCC_MAX_SERVICES; i++)
+	{
+		if (!opts->services_enabled[i])
+			continue;
+		ctx->services_active |= (uint64_t)1 << i;
+		ctx->service_slot[i] = (unsigned char)ctx->active_services_count++;
+	}
 
 	dtvcc_clear_packet(ctx);
 
@@ -112,26 +140,23 @@ dtvcc_ctx *dtvcc_init(struct cea_decoder_dtvcc_settings *opts)
 
 	ctx->report_enabled = opts->print_file_reports;
 	ctx->timing = opts->timing;
-
-	dbg_print(CEA_DMT_708, "[CEA-708] initializing services\n");
-
-	for (int i = 0; i < CEA_DTVCC_MAX_SERVICES; i++)
+	ctx->log = opts->log;
+	ctx->ring = NULL;
+	ctx->live_tv = NULL;
+	ctx->live_text = NULL;
+	ctx->live_text_size = 0;
+
+	// Service decoders are allocated when their service first carries data
+	ctx->decoders = NULL;
+	if (ctx->active_services_count)
 	{
-		if (!ctx->services_active[i])
-			continue;
-
-		dtvcc_service_decoder *decoder = &ctx->decoders[i];
-		decoder->cc_count = 0;
-		decoder->tv = (dtvcc_tv_screen *)malloc(sizeof(dtvcc_tv_screen));
-		if (!decoder->tv)
-			fatal(EXIT_NOT_ENOUGH_MEMORY, "dtvcc_init");
-		decoder->tv->service_number = i + 1;
-		decoder->tv->cc_count = 0;
-
-		for (int j = 0; j < CEA_DTVCC_MAX_WINDOWS; j++)
-			decoder->windows[j].memory_reserved = 0;
-
-		dtvcc_windows_reset(decoder);
+		ctx->decoders = (dtvcc_service_decoder **)calloc(ctx->active_services_count, sizeof(dtvcc_service_decoder *));
+		if (!ctx->decoders)
+		{
+			free(ctx);
+			fatal(opts->log, EXIT_NOT_ENOUGH_MEMORY, "[CEA-708] dtvcc_init");
+			return NULL;
+		}
 	}
 
 	return ctx;
@@ -139,26 +164,14 @@ dtvcc_ctx *dtvcc_init(struct cea_decoder_dtvcc_settings *opts)
 
 void dtvcc_free(dtvcc_ctx **ctx_ptr)
 {
-	dbg_print(CEA_DMT_708, "[CEA-708] dtvcc_free: cleaning up\n");
-
 	dtvcc_ctx *ctx = *ctx_ptr;
 
-	for (int i = 0; i < CEA_DTVCC_MAX_SERVICES; i++)
-	{
-		if (!ctx->services_active[i])
-			continue;
+	dbg_print(ctx->log, CEA_DMT_708, "[CEA-708] dtvcc_free: cleaning up\n");
 
-		dtvcc_service_decoder *decoder = &ctx->decoders[i];
-
-		for (int j = 0; j < CEA_DTVCC_MAX_WINDOWS; j++)
-			if (decoder->windows[j].memory_reserved)
-			{
-				for (int k = 0; k < CEA_DTVCC_MAX_ROWS; k++)
-					free(decoder->windows[j].rows[k]);
-				decoder->windows[j].memory_reserved = 0;
-			}
-
-		free(decoder->tv);
-	}
+	for (int i = 0; i < ctx->active_services_count; i++)
+		dtvcc_service_decoder_free(ctx->decoders[i]);
+	free(ctx->decoders);
+	dtvcc_tv_free(ctx->live_tv);
+	free(ctx->live_text);
 	freep(ctx_ptr);
 }
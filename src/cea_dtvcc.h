@@ -11,8 +11,10 @@
 
 #include "cea_decoders_708.h"
 
-void dtvcc_process_data(struct dtvcc_ctx *dtvcc,
-			const unsigned char *data);
+/* Feed a cc_data array (cc_count triplets) to the DTVCC packet assembler.
+ * Runs of packet data are copied in one go and each packet is decoded
+ * as soon as it is complete. */
+void dtvcc_process_cc_data(struct dtvcc_ctx *dtvcc, const unsigned char *cc_data, int cc_count);
 
 dtvcc_ctx *dtvcc_init(cea_decoder_dtvcc_settings *opts);
 void dtvcc_free(dtvcc_ctx **);
@@ -10,22 +10,16 @@
 #include "cea_common_common.h"
 
 void printdata(struct lib_cc_decode *ctx, const unsigned char *data1, int length1,
-	       const unsigned char *data2, int length2, struct cc_subtitle *sub)
+	       const unsigned char *data2, int length2, struct cc_caption_ring *ring)
 {
 	if (length1 && ctx->extract != 2)
 	{
 		ctx->current_field = 1;
-		ctx->current_channel = 1;
-		ctx->writedata(data1, length1, ctx, sub);
-		ctx->current_channel = 2;
-		ctx->writedata(data1, length1, ctx, sub);
+		ctx->writedata(data1, length1, ctx, ring);
 	}
 	if (length2 && ctx->extract != 1)
 	{
 		ctx->current_field = 2;
-		ctx->current_channel = 1;
-		ctx->writedata(data2, length2, ctx, sub);
-		ctx->current_channel = 2;
-		ctx->writedata(data2, length2, ctx, sub);
+		ctx->writedata(data2, length2, ctx, ring);
 	}
 }
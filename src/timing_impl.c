@@ -11,16 +11,6 @@
 #include <stdio.h>
 #include <string.h>
 
-/* External globals defined in cea_common_timing.c */
-extern int cb_field1, cb_field2, cb_708;
-extern int MPEG_CLOCK_FREQ;
-extern int max_dif;
-extern unsigned pts_big_change;
-extern double current_fps;
-extern int frames_since_ref_time;
-extern unsigned total_frames_count;
-extern struct cea_common_timing_settings_t cea_common_timing_settings;
-
 /* Helper: convert MPEG clock ticks to milliseconds */
 static int64_t ticks_to_ms(int64_t ticks, int clock_freq)
 {
@@ -69,19 +59,19 @@ int cea_set_fts(struct cea_common_timing_ctx *ctx)
 	int pts_jump = 0;
 
 	/* Phase 1: Elementary stream with no PTS yet */
-	if (ctx->pts_set == 0 && cea_common_timing_settings.is_elementary_stream)
+	if (ctx->pts_set == 0 && ctx->settings.is_elementary_stream)
 		return 1;
 
 	/* Phase 2: PTS jump detection */
-	if (ctx->pts_set == 2 && !cea_common_timing_settings.disable_sync_check) /* MinPtsSet */
+	if (ctx->pts_set == 2 && !ctx->settings.disable_sync_check) /* MinPtsSet */
 	{
 		int64_t dif_ticks = ctx->current_pts - ctx->sync_pts;
 		int64_t dif_sec = ticks_to_ms(dif_ticks, MPEG_CLOCK_FREQ) / 1000;
 
-		if (dif_sec < 0 || dif_sec > max_dif)
+		if (dif_sec < 0 || dif_sec > ctx->max_dif)
 		{
 			pts_jump = 1;
-			pts_big_change = 1;
+			ctx->pts_big_change = 1;
 
 			/* If not at GOP start, can't fully resync -- estimate and return */
 			if (ctx->current_tref != 0 ||
@@ -186,29 +176,29 @@ int cea_set_fts(struct cea_common_timing_ctx *ctx)
 
 			/* Calculate sync_pts (PTS at GOP start, tref=0) */
 			ctx->sync_pts = ctx->current_pts -
-					frames_to_ticks(ctx->current_tref, current_fps, MPEG_CLOCK_FREQ);
+					frames_to_ticks(ctx->current_tref, ctx->current_fps, MPEG_CLOCK_FREQ);
 
 			/* Calculate fts_offset (time before first sync_pts) */
 			if (ctx->current_tref == 0 ||
-			    ((int)total_frames_count - frames_since_ref_time) == 0)
+			    ((int)ctx->total_frames_count - ctx->frames_since_ref_time) == 0)
 			{
 				ctx->fts_offset = 0;
 			}
 			else
 			{
 				ctx->fts_offset = frames_to_ms(
-					(int)total_frames_count - frames_since_ref_time + 1,
-					current_fps);
+					(int)ctx->total_frames_count - ctx->frames_since_ref_time + 1,
+					ctx->current_fps);
 			}
 		}
 	}
 
 	/* Phase 5: Handle PTS jump (after min_pts is set) */
-	if (pts_jump && !cea_common_timing_settings.no_sync)
+	if (pts_jump && !ctx->settings.no_sync)
 	{
 		ctx->fts_offset = ctx->fts_offset +
 				  ticks_to_ms(ctx->sync_pts - ctx->min_pts, MPEG_CLOCK_FREQ) +
-				  frames_to_ms(frames_since_ref_time, current_fps);
+				  frames_to_ms(ctx->frames_since_ref_time, ctx->current_fps);
 		ctx->fts_max = ctx->fts_offset;
 
 		/* Reset sync tracking for new timeline */
@@ -216,7 +206,7 @@ int cea_set_fts(struct cea_common_timing_ctx *ctx)
 
 		/* Set new sync_pts accounting for temporal reference offset */
 		ctx->sync_pts = ctx->current_pts -
-				frames_to_ticks(ctx->current_tref, current_fps, MPEG_CLOCK_FREQ);
+				frames_to_ticks(ctx->current_tref, ctx->current_fps, MPEG_CLOCK_FREQ);
 
 		/* Set min_pts = sync_pts to enable fts_now calculation */
 		ctx->min_pts = ctx->sync_pts;
@@ -228,9 +218,9 @@ int cea_set_fts(struct cea_common_timing_ctx *ctx)
 		ctx->sync_pts = ctx->current_pts;
 
 	/* Phase 7: Reset caption counters */
-	cb_field1 = 0;
-	cb_field2 = 0;
-	cb_708 = 0;
+	ctx->cb_field1 = 0;
+	ctx->cb_field2 = 0;
+	ctx->cb_708 = 0;
 
 	/* Phase 8: Calculate fts_now */
 	if (ctx->pts_set == 2) /* MinPtsSet */
@@ -276,13 +266,13 @@ int64_t cea_get_fts(struct cea_common_timing_ctx *ctx, int current_field)
 	switch (current_field)
 	{
 	case 1:
-		count = cb_field1;
+		count = ctx->cb_field1;
 		break;
 	case 2:
-		count = cb_field2;
+		count = ctx->cb_field2;
 		break;
 	case 3:
-		count = cb_708;
+		count = ctx->cb_708;
 		break;
 	default:
 		count = 0;
@@ -322,9 +312,9 @@ int64_t cea_get_visible_end(struct cea_common_timing_ctx *ctx, int current_field
 }
 
 /*
- * print_mstime_static: Format time as HH:MM:SS:mmm
+ * print_mstime: Format time as HH:MM:SS:mmm into buf (CEA_MSTIME_BUF_SIZE bytes)
  */
-char *cea_print_mstime_static(int64_t mstime, char *buf)
+char *cea_print_mstime(int64_t mstime, char *buf)
 {
 	unsigned hh, mm, ss, ms;
 	int sign = 0;
@@ -341,9 +331,9 @@ char *cea_print_mstime_static(int64_t mstime, char *buf)
 	ms = (unsigned)(mstime - 1000 * (ss + 60 * (mm + 60 * hh)));
 
 	if (sign)
-		snprintf(buf, 15, "-%02u:%02u:%02u:%03u", hh, mm, ss, ms);
+		snprintf(buf, CEA_MSTIME_BUF_SIZE, "-%02u:%02u:%02u:%03u", hh, mm, ss, ms);
 	else
-		snprintf(buf, 15, "%02u:%02u:%02u:%03u", hh, mm, ss, ms);
+		snprintf(buf, CEA_MSTIME_BUF_SIZE, "%02u:%02u:%02u:%03u", hh, mm, ss, ms);
 
 	return buf;
 }
@@ -58,8 +58,1399 @@ static void feed_test_sequence(cea_ctx *ctx)
 	cea_flush(ctx);
 }
 
+/* Feed one field 1 byte pair (already parity-coded) */
+static void feed_608_pair(cea_ctx *ctx, unsigned char b1, unsigned char b2, int64_t pts_ms)
+{
+	unsigned char cc[3] = { 0x04, b1, b2 };
+	cea_feed(ctx, cc, 1, pts_ms);
+}
+
+/* The 608 byte pair of frame n of a CC1 or CC2 "Test" pop-on caption:
+   RCL, "Te", "st", EOC, nulls, EDM at frame 40 */
+static void frame_triplet(int n, int channel, unsigned char *cc)
+{
+	unsigned char ctrl = channel == 2 ? 0x1C : 0x94;
+	unsigned char pair[2] = { 0x80, 0x80 };
+
+	switch (n)
+	{
+		case 0: pair[0] = ctrl; pair[1] = 0x20; break; /* RCL */
+		case 1: pair[0] = 0x54; pair[1] = 0xE5; break; /* "Te" */
+		case 2: pair[0] = 0x73; pair[1] = 0xF4; break; /* "st" */
+		case 3: pair[0] = ctrl; pair[1] = 0x2F; break; /* EOC */
+		case 40: pair[0] = ctrl; pair[1] = 0x2C; break; /* EDM */
+	}
+	cc[0] = 0xFC;
+	cc[1] = pair[0];
+	cc[2] = pair[1];
+}
+
+/* Two roll-up screens that both start before any visible start time is
+   known (start 0) must each keep their own interval instead of sharing
+   the later one. Returns the number of failures. */
+static int test_608_pending_at_zero(void)
+{
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+
+	int n = 0;
+	feed_608_pair(ctx, 0x94, 0x25, n++ * 33); /* RU2 */
+	feed_608_pair(ctx, 0xC1, 0xC2, n++ * 33); /* "AB" */
+	while (n < 30)
+		feed_608_pair(ctx, 0x80, 0x80, n++ * 33);
+	feed_608_pair(ctx, 0x94, 0x2C, n++ * 33); /* EDM */
+	feed_608_pair(ctx, 0x43, 0xC4, n++ * 33); /* "CD" */
+	while (n < 60)
+		feed_608_pair(ctx, 0x80, 0x80, n++ * 33);
+	feed_608_pair(ctx, 0x94, 0x2C, n++ * 33); /* EDM */
+	while (n < 70)
+		feed_608_pair(ctx, 0x80, 0x80, n++ * 33);
+	cea_flush(ctx);
+
+	cea_caption captions[8];
+	int count = cea_get_captions(ctx, captions, 8);
+	int failures = 0;
+	if (count != 2 || !strstr(captions[0].text, "AB") || !strstr(captions[1].text, "CD") ||
+	    captions[0].start_ms != 0 || captions[0].end_ms > captions[1].start_ms ||
+	    captions[1].start_ms >= captions[1].end_ms)
+	{
+		fprintf(stderr, "FAIL: 608 screens pending at 0 share their times\n");
+		failures++;
+	}
+	else
+		printf("PASS: 608 screens pending at 0 keep their own times\n");
+	cea_free(ctx);
+	return failures;
+}
+
+/* One byte pair of a scripted CC1/CC2 stream, sent at frame (33 ms) */
+struct cc_608_step
+{
+	int frame;
+	unsigned char b1, b2;
+};
+
+/* A caption a golden-output test expects, in cea_get_captions() order */
+struct golden_caption
+{
+	int field;
+	int channel;
+	int64_t start_ms;
+	int64_t end_ms;
+	const char *text;
+};
+
+/* Feed a script on field 1 over the given number of frames, with null
+   pairs in the frames it leaves out */
+static void feed_608_script(cea_ctx *ctx, const struct cc_608_step *script, int steps, int frames)
+{
+	int k = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		if (k < steps && script[k].frame == frame)
+		{
+			feed_608_pair(ctx, script[k].b1, script[k].b2, 1000 + frame * 33);
+			k++;
+		}
+		else
+			feed_608_pair(ctx, 0x80, 0x80, 1000 + frame * 33);
+	}
+	cea_flush(ctx);
+}
+
+/* Compare the captions of ctx with the expected ones. Returns the number
+   of failures. */
+static int check_golden(const char *name, cea_ctx *ctx, const struct golden_caption *want, int want_count)
+{
+	cea_caption got[16];
+	int count = cea_get_captions(ctx, got, 16);
+	for (int i = 0; i < count || i < want_count; i++)
+	{
+		if (i < count && i < want_count && got[i].field == want[i].field &&
+		    got[i].channel == want[i].channel && got[i].start_ms == want[i].start_ms &&
+		    got[i].end_ms == want[i].end_ms && got[i].text && strcmp(got[i].text, want[i].text) == 0)
+			continue;
+		if (i < count)
+			fprintf(stderr, "FAIL: %s: caption %d is %d/%d %lld-%lld '%s'\n", name, i,
+				got[i].field, got[i].channel, (long long)got[i].start_ms,
+				(long long)got[i].end_ms, got[i].text ? got[i].text : "(null)");
+		else
+			fprintf(stderr, "FAIL: %s: caption %d missing\n", name, i);
+		return 1;
+	}
+	printf("PASS: %s\n", name);
+	return 0;
+}
+
+/* Control codes of every class on CC1 and CC2: pop-on with PACs, a
+   mid-row code and a backspace, repeated codes, ENM, roll-up with
+   carriage returns, paint-on with a tab offset and a special character.
+   Returns the number of failures. */
+static int test_608_golden(void)
+{
+	static const struct cc_608_step script[] = {
+		{   0, 0x94, 0x20 }, /* RCL */
+		{   1, 0x94, 0x20 }, /* RCL (repeat) */
+		{   2, 0x94, 0x52 }, /* PAC row 14, indent 4 */
+		{   3, 0xC8, 0xE5 }, /* "He" */
+		{   4, 0xEC, 0xEC }, /* "ll" */
+		{   5, 0xEF, 0xA1 }, /* "o!" */
+		{   6, 0x94, 0xE0 }, /* PAC row 15 */
+		{   7, 0x57, 0xEF }, /* "Wo" */
+		{   8, 0x91, 0xAE }, /* mid-row italics */
+		{   9, 0xF2, 0xEC }, /* "rl" */
+		{  10, 0x64, 0x80 }, /* "d" */
+		{  11, 0x94, 0xA1 }, /* BS */
+		{  12, 0xC4, 0x80 }, /* "D" */
+		{  13, 0x94, 0x2F }, /* EOC */
+		{  14, 0x94, 0x2F }, /* EOC (repeat) */
+		{  40, 0x94, 0xAE }, /* ENM */
+		{  41, 0x94, 0x20 }, /* RCL */
+		{  42, 0x94, 0xE0 }, /* PAC row 15 */
+		{  43, 0x58, 0x80 }, /* "X" */
+		{  44, 0x94, 0x2F }, /* EOC */
+		{  60, 0x94, 0x2C }, /* EDM */
+		{  70, 0x94, 0x26 }, /* RU3 */
+		{  71, 0x94, 0xE0 }, /* PAC row 15 */
+		{  72, 0x4F, 0x6E }, /* "On" */
+		{  73, 0xE5, 0x80 }, /* "e" */
+		{  74, 0x94, 0xAD }, /* CR */
+		{  75, 0x54, 0xF7 }, /* "Tw" */
+		{  76, 0xEF, 0x80 }, /* "o" */
+		{  77, 0x94, 0xAD }, /* CR */
+		{  78, 0x54, 0x68 }, /* "Th" */
+		{  79, 0xF2, 0xE5 }, /* "re" */
+		{  80, 0xE5, 0x80 }, /* "e" */
+		{  81, 0x94, 0xAD }, /* CR */
+		{  82, 0x46, 0xEF }, /* "Fo" */
+		{  83, 0x75, 0xF2 }, /* "ur" */
+		{ 100, 0x94, 0x2C }, /* EDM */
+		{ 110, 0x94, 0x29 }, /* RDC */
+		{ 111, 0x91, 0x40 }, /* PAC row 1 */
+		{ 112, 0xD0, 0x61 }, /* "Pa" */
+		{ 113, 0xE9, 0x6E }, /* "in" */
+		{ 114, 0xF4, 0x80 }, /* "t" */
+		{ 115, 0x97, 0xA2 }, /* TO2 */
+		{ 116, 0x58, 0xD9 }, /* "XY" */
+		{ 117, 0x91, 0x37 }, /* music note */
+		{ 130, 0x94, 0x2C }, /* EDM */
+		{ 140, 0x1C, 0x20 }, /* CC2 RCL */
+		{ 141, 0x43, 0x32 }, /* "C2" */
+		{ 142, 0x1C, 0x2F }, /* CC2 EOC */
+		{ 160, 0x1C, 0x2C }, /* CC2 EDM */
+	};
+	static const struct golden_caption want[] = {
+		{ 1, 1, 430, 1452, "    Hello!\nWo <i>rlD</i>" },
+		{ 1, 1, 1453, 1980, "X" },
+		{ 1, 1, 2541, 2673, "One\nTwo\nThree" },
+		{ 1, 1, 2674, 3300, "Two\nThree\nFour" },
+		{ 1, 1, 3696, 4290, "Paint  XY\xE2\x99\xAA" },
+		{ 1, 2, 4687, 5280, "C2" },
+	};
+
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	feed_608_script(ctx, script, (int)(sizeof(script) / sizeof(script[0])), 200);
+	int failures = check_golden("608 control codes golden output", ctx, want,
+				    (int)(sizeof(want) / sizeof(want[0])));
+	cea_free(ctx);
+	return failures;
+}
+
+/* With CC1 disabled, only the CC2 caption comes out. Returns the number
+   of failures. */
+static int test_cc2_only(void)
+{
+	cea_options opts = { 0 };
+	opts.disable_608 = CEA_608_CC1;
+	cea_ctx *ctx = cea_init(&opts);
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init() returned NULL\n");
+		return 1;
+	}
+
+	unsigned char cc[3];
+	for (int channel = 1; channel <= 2; channel++)
+	{
+		for (int n = 0; n < 60; n++)
+		{
+			frame_triplet(n, channel, cc);
+			cea_feed(ctx, cc, 1, (channel - 1) * 5000 + 1000 + n * 33);
+		}
+	}
+	cea_flush(ctx);
+
+	cea_caption captions[8];
+	int count = cea_get_captions(ctx, captions, 8);
+	int failures = 0;
+	if (count != 1 || captions[0].field != 1 || captions[0].channel != 2 ||
+	    !captions[0].text || strcmp(captions[0].text, "Test") != 0)
+	{
+		fprintf(stderr, "FAIL: CC2 only: got %d caption(s)\n", count);
+		failures++;
+	}
+	else
+		printf("PASS: decoded CC2 with CC1 disabled\n");
+	cea_free(ctx);
+	return failures;
+}
+
+/* Wrap service blocks in a DTVCC packet: a packet start triplet and
+   packet data triplets, padded to whole byte pairs. *seq is the packet
+   sequence number, advanced per packet. Returns the number of triplets. */
+static int put_dtvcc_packet(unsigned char *cc, const unsigned char *blocks, int len, int *seq)
+{
+	unsigned char pkt[128] = { 0 };
+	int size = 1 + len;
+	if (size & 1)
+		size++;
+
+	pkt[0] = (unsigned char)((*seq << 6) | (size / 2));
+	memcpy(pkt + 1, blocks, len);
+	*seq = (*seq + 1) & 3;
+
+	for (int i = 0; i < size / 2; i++)
+	{
+		cc[i * 3] = i == 0 ? 0xFF : 0xFE;
+		cc[i * 3 + 1] = pkt[i * 2];
+		cc[i * 3 + 2] = pkt[i * 2 + 1];
+	}
+	return size / 2;
+}
+
+/* Write one service block (service 1-6) as a DTVCC packet. Returns the
+   number of triplets. */
+static int put_dtvcc_block(unsigned char *cc, int service, const unsigned char *block, int len, int *seq)
+{
+	unsigned char blocks[64];
+	blocks[0] = (unsigned char)((service << 5) | len);
+	memcpy(blocks + 1, block, len);
+	return put_dtvcc_packet(cc, blocks, 1 + len, seq);
+}
+
+/* Feed one service block as a DTVCC packet on its own */
+static void feed_dtvcc_block(cea_ctx *ctx, int service, const unsigned char *block, int len,
+			     int *seq, int64_t pts_ms)
+{
+	unsigned char cc[64 * 3];
+	int count = put_dtvcc_block(cc, service, block, len, seq);
+	cea_feed(ctx, cc, count, pts_ms);
+}
+
+/* A 708 caption on service 1 that ends before a CC1 caption does */
+static void feed_708_then_608(cea_ctx *ctx)
+{
+	/* DefineWindow 0 (visible, 2x32 at 0,0), "Hi" */
+	static const unsigned char define[] = { 0x98, 0x38, 0x00, 0x00, 0x01, 0x1F, 0x09, 'H', 'i' };
+	/* ClearWindows 0 */
+	static const unsigned char clear[] = { 0x88, 0x01 };
+	int seq = 0;
+
+	feed_dtvcc_block(ctx, 1, define, (int)sizeof(define), &seq, 0);
+	feed_608_pair(ctx, 0x94, 0x20, 33);  /* RCL */
+	feed_608_pair(ctx, 0xC1, 0xC2, 66);  /* "AB" */
+	feed_608_pair(ctx, 0x94, 0x2F, 100); /* EOC */
+	feed_dtvcc_block(ctx, 1, clear, (int)sizeof(clear), &seq, 500);
+	feed_608_pair(ctx, 0x94, 0x2C, 1000); /* EDM */
+	for (int n = 1; n <= 10; n++)
+		feed_608_pair(ctx, 0x80, 0x80, 1000 + n * 33);
+	cea_flush(ctx);
+}
+
+/* Feed 80 frames of cc_data as an encoder sends it: a CC1 pair, a field 2
+   (CC3) pair, a DTVCC packet or DTVCC padding, and triplets marked
+   invalid that would change the captions if they were decoded */
+static void feed_mixed_cc_data(cea_ctx *ctx)
+{
+	/* DefineWindow 0 (visible, 2x32 at 0,0), "Svc1"; then ClearWindows 0 */
+	static const unsigned char define[] = { 0x98, 0x38, 0x00, 0x00, 0x01, 0x1F, 0x09, 'S', 'v', 'c', '1' };
+	static const unsigned char clear[] = { 0x88, 0x01 };
+	int seq = 0;
+
+	for (int frame = 0; frame < 80; frame++)
+	{
+		unsigned char cc[10 * 3];
+		int count = 2;
+
+		frame_triplet(frame, 1, cc);
+		frame_triplet(frame - 20, 1, cc + 3);
+		cc[3] = 0xFD; /* field 2: CC3 */
+
+		/* Invalid: EDM on CC1, then "Xx" on CC3 */
+		if (frame == 10)
+			memcpy(cc + count++ * 3, "\xF8\x94\x2C", 3);
+		if (frame == 21 || frame == 22)
+			memcpy(cc + count++ * 3, "\xF9\x58\xF8", 3);
+
+		if (frame == 5)
+			count += put_dtvcc_block(cc + count * 3, 1, define, (int)sizeof(define), &seq);
+		if (frame == 50)
+			count += put_dtvcc_block(cc + count * 3, 1, clear, (int)sizeof(clear), &seq);
+		while (count < 10)
+			memcpy(cc + count++ * 3, "\xFA\x00\x00", 3); /* DTVCC padding */
+		cea_feed(ctx, cc, count, 1000 + frame * 33);
+	}
+	cea_flush(ctx);
+}
+
+/* Golden output of feed_mixed_cc_data: padding and invalid triplets are
+   skipped and each valid one reaches its decoder. Returns the number of
+   failures. */
+static int test_cc_data_golden(void)
+{
+	static const struct golden_caption want[] = {
+		{ 1, 1, 100, 1320, "Test" },
+		{ 2, 1, 760, 1980, "Test" },
+		{ 3, 1, 165, 1650, "Svc1" },
+	};
+
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	feed_mixed_cc_data(ctx);
+	int failures = check_golden("mixed cc_data golden output", ctx, want,
+				    (int)(sizeof(want) / sizeof(want[0])));
+	cea_free(ctx);
+	return failures;
+}
+
+/* Both getters return 608 captions before 708 ones, whatever order they
+   completed in, also when the caller takes them one at a time. Returns
+   the number of failures. */
+static int test_caption_order(void)
+{
+	cea_ctx *ctx[3];
+	for (int i = 0; i < 3; i++)
+	{
+		ctx[i] = cea_init_default();
+		if (!ctx[i])
+		{
+			fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+			return 1;
+		}
+		feed_708_then_608(ctx[i]);
+	}
+
+	cea_caption all[4], into[4], one[4];
+	char arena[64], arena_one[2][32];
+	int all_count = cea_get_captions(ctx[0], all, 4);
+	int into_count = cea_get_captions_into(ctx[1], into, 4, arena, sizeof(arena), NULL);
+	int one_count = 0;
+	for (int i = 0; i < 2; i++)
+		one_count += cea_get_captions_into(ctx[2], &one[i], 1, arena_one[i], sizeof(arena_one[i]), NULL);
+
+	int failures = 0;
+	if (all_count != 2 || into_count != 2 || one_count != 2 ||
+	    strcmp(all[0].info, "608") != 0 || strcmp(all[1].info, "708") != 0)
+		failures++;
+	for (int i = 0; !failures && i < 2; i++)
+	{
+		if (strcmp(all[i].text, into[i].text) != 0 || strcmp(all[i].text, one[i].text) != 0 ||
+		    all[i].start_ms != into[i].start_ms || all[i].start_ms != one[i].start_ms)
+			failures++;
+	}
+	if (failures)
+		fprintf(stderr, "FAIL: caption order differs between getters\n");
+	else
+		printf("PASS: both getters return 608 captions, then 708\n");
+
+	for (int i = 0; i < 3; i++)
+		cea_free(ctx[i]);
+	return failures;
+}
+
+/* Live callback events seen by test_708_live */
+struct live_log
+{
+	int count;
+	int field[8];
+	int channel[8];
+	char text[8][16]; /* "" for a clear event */
+};
+
+static void on_live_708(const cea_caption *cap, void *userdata)
+{
+	struct live_log *log = (struct live_log *)userdata;
+	if (log->count == 8)
+		return;
+	log->field[log->count] = cap->field;
+	log->channel[log->count] = cap->channel;
+	snprintf(log->text[log->count], sizeof(log->text[0]), "%s", cap->text ? cap->text : "");
+	log->count++;
+}
+
+/* A hidden 708 window gets text, is displayed and then cleared: the live
+   callback must show its text once when it is displayed and clear it
+   once. Returns the number of failures. */
+static int test_708_live(void)
+{
+	/* DefineWindow 0 (hidden, 2x32 at 0,0), "Hi" */
+	static const unsigned char define[] = { 0x98, 0x18, 0x00, 0x00, 0x01, 0x1F, 0x09, 'H', 'i' };
+	static const unsigned char display[] = { 0x89, 0x01 }; /* DisplayWindows 0 */
+	static const unsigned char clear[] = { 0x88, 0x01 };   /* ClearWindows 0 */
+	struct live_log log = { 0 };
+	int seq = 0;
+
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	cea_set_caption_callback(ctx, on_live_708, &log);
+
+	feed_dtvcc_block(ctx, 1, define, (int)sizeof(define), &seq, 0);
+	int hidden_events = log.count;
+	feed_dtvcc_block(ctx, 1, display, (int)sizeof(display), &seq, 100);
+	int shown_events = log.count;
+	feed_dtvcc_block(ctx, 1, clear, (int)sizeof(clear), &seq, 1000);
+	cea_flush(ctx);
+	cea_free(ctx);
+
+	int failures = 0;
+	if (hidden_events != 0 || shown_events != 1 || log.count != 2 ||
+	    log.field[0] != 3 || log.channel[0] != 1 || strcmp(log.text[0], "Hi") != 0 ||
+	    log.field[1] != 3 || log.channel[1] != 1 || log.text[1][0] != '\0')
+	{
+		fprintf(stderr, "FAIL: 708 live events:");
+		for (int i = 0; i < log.count; i++)
+			fprintf(stderr, " %d/%d '%s'", log.field[i], log.channel[i], log.text[i]);
+		fprintf(stderr, "\n");
+		failures++;
+	}
+	else
+		printf("PASS: 708 live show and clear events\n");
+	return failures;
+}
+
+/* Feed three DTVCC packets for service 1 a few triplets per frame, so
+   that packets start and end in the middle of a cea_feed() call */
+static void feed_split_708(cea_ctx *ctx, int per_frame)
+{
+	/* DefineWindow 0 (visible, 2x32 at 0,0), "Split across" */
+	static const unsigned char define[] = {
+		0x98, 0x38, 0x00, 0x00, 0x01, 0x1F, 0x09,
+		'S', 'p', 'l', 'i', 't', ' ', 'a', 'c', 'r', 'o', 's', 's'
+	};
+	static const unsigned char text[] = { 0x0D, 'f', 'e', 'e', 'd', 's' }; /* CR, "feeds" */
+	static const unsigned char clear[] = { 0x88, 0x01 };                     /* ClearWindows 0 */
+	unsigned char queue[32 * 3];
+	int seq = 0;
+
+	int queued = put_dtvcc_block(queue, 1, define, (int)sizeof(define), &seq);
+	queued += put_dtvcc_block(queue + queued * 3, 1, text, (int)sizeof(text), &seq);
+	int clear_at = queued;
+	queued += put_dtvcc_block(queue + queued * 3, 1, clear, (int)sizeof(clear), &seq);
+
+	int sent = 0;
+	for (int frame = 0; frame < 60; frame++)
+	{
+		unsigned char cc[8 * 3];
+		int count = 0;
+		/* Hold the ClearWindows packet back until frame 40 */
+		int limit = frame < 40 ? clear_at : queued;
+		while (count < per_frame && sent < limit)
+		{
+			memcpy(cc + count * 3, queue + sent * 3, 3);
+			count++;
+			sent++;
+		}
+		while (count < per_frame)
+			memcpy(cc + count++ * 3, "\xFA\x00\x00", 3); /* DTVCC padding */
+		cea_feed(ctx, cc, count, 1000 + frame * 33);
+	}
+	cea_flush(ctx);
+}
+
+/* Golden output of feed_split_708 at 1, 3 and 5 triplets per frame: the
+   packets decode the same however they are cut. Returns the number of
+   failures. */
+static int test_708_split_golden(void)
+{
+	static const struct
+	{
+		int per_frame;
+		struct golden_caption want;
+	} cases[] = {
+		{ 1, { 3, 1, 463, 1353, "Split across\nfeeds" } },
+		{ 3, { 3, 1, 133, 1320, "Split across\nfeeds" } },
+		{ 5, { 3, 1, 67, 1320, "Split across\nfeeds" } },
+	};
+	int failures = 0;
+
+	for (int c = 0; c < 3; c++)
+	{
+		cea_ctx *ctx = cea_init_default();
+		if (!ctx)
+		{
+			fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+			return failures + 1;
+		}
+		char name[64];
+		snprintf(name, sizeof(name), "708 packets split %d triplet(s) per feed", cases[c].per_frame);
+		feed_split_708(ctx, cases[c].per_frame);
+		failures += check_golden(name, ctx, &cases[c].want, 1);
+		cea_free(ctx);
+	}
+	return failures;
+}
+
+/* Feed DTVCC packets carrying several service blocks each, for services
+   1, 2, 3 and 10 (extended service block header) */
+static void feed_multi_service(cea_ctx *ctx)
+{
+	/* Service 1 "One", 2 "Two" and 3 "Off" in one packet; DefineWindow 0
+	   (visible, 2x32 at 0,0) each */
+	static const unsigned char first[] = {
+		0x2A, 0x98, 0x38, 0x00, 0x00, 0x01, 0x1F, 0x09, 'O', 'n', 'e',
+		0x4A, 0x98, 0x38, 0x00, 0x00, 0x01, 0x1F, 0x09, 'T', 'w', 'o',
+		0x6A, 0x98, 0x38, 0x00, 0x00, 0x01, 0x1F, 0x09, 'O', 'f', 'f',
+	};
+	/* Service 10 (extended header) "Ten" */
+	static const unsigned char second[] = {
+		0xEA, 0x0A, 0x98, 0x38, 0x00, 0x00, 0x01, 0x1F, 0x09, 'T', 'e', 'n',
+	};
+	/* ClearWindows 0 on service 2, then on services 1, 3 and 10 */
+	static const unsigned char third[] = { 0x42, 0x88, 0x01 };
+	static const unsigned char fourth[] = { 0x22, 0x88, 0x01, 0x62, 0x88, 0x01, 0xE2, 0x0A, 0x88, 0x01 };
+	static const struct
+	{
+		int frame;
+		const unsigned char *data;
+		int len;
+	} packets[] = {
+		{ 0, first, (int)sizeof(first) },
+		{ 2, second, (int)sizeof(second) },
+		{ 30, third, (int)sizeof(third) },
+		{ 40, fourth, (int)sizeof(fourth) },
+	};
+	int seq = 0, k = 0;
+
+	for (int frame = 0; frame < 60; frame++)
+	{
+		unsigned char cc[32 * 3];
+		int count = 0;
+		if (k < 4 && packets[k].frame == frame)
+		{
+			count = put_dtvcc_packet(cc, packets[k].data, packets[k].len, &seq);
+			k++;
+		}
+		else
+			memcpy(cc + count++ * 3, "\xFA\x00\x00", 3); /* DTVCC padding */
+		cea_feed(ctx, cc, count, 1000 + frame * 33);
+	}
+	cea_flush(ctx);
+}
+
+/* Golden output of feed_multi_service with services 1, 2 and 10 enabled:
+   each enabled service decodes its own blocks, service 3 is skipped.
+   Returns the number of failures. */
+static int test_708_services_golden(void)
+{
+	static const struct golden_caption want[] = {
+		{ 3, 2, 1, 990, "Two" },
+		{ 3, 1, 1, 1320, "One" },
+		{ 3, 10, 66, 1320, "Ten" },
+	};
+	cea_options opts = { 0 };
+	opts.enable_708 = 1;
+	opts.services_708[0] = 1;
+	opts.services_708[1] = 1;
+	opts.services_708[9] = 1;
+
+	cea_ctx *ctx = cea_init(&opts);
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init() returned NULL\n");
+		return 1;
+	}
+	feed_multi_service(ctx);
+	int failures = check_golden("708 services golden output", ctx, want,
+				    (int)(sizeof(want) / sizeof(want[0])));
+	cea_free(ctx);
+	return failures;
+}
+
+/* Length-prefixed (AVCC) H.264 packets whose NAL length runs past the
+   packet, up to prefixes that are negative as an int, must be dropped
+   without reading outside the packet. Returns the number of failures. */
+static int test_hostile_nal_length(void)
+{
+	/* AUD, then a NAL claiming 0x80000000 bytes, then an SEI header */
+	static const unsigned char after_valid[] = {
+		0x00, 0x00, 0x00, 0x02, 0x09, 0x10,
+		0x80, 0x00, 0x00, 0x00,
+		0x06, 0x04, 0x03, 0xB5, 0x00, 0x31, 0x80
+	};
+	/* SEI whose length prefix runs past the end of the packet */
+	static const unsigned char truncated[] = {
+		0x00, 0x00, 0x00, 0x20, 0x06, 0x04, 0x0E, 0xB5, 0x00, 0x31,
+		0x47, 0x41, 0x39, 0x34, 0x03, 0x41, 0xFF, 0xFC, 0x94, 0x20
+	};
+	/* Hostile length as the very first prefix (length size detection) */
+	static const unsigned char first[] = {
+		0xFF, 0xFF, 0xFF, 0xFF, 0x06, 0x04, 0x03, 0xB5, 0x00, 0x31, 0x80
+	};
+	int failures = 0;
+
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_AVCC, NULL, 0);
+	for (int i = 0; i < 4; i++)
+		cea_feed_packet(ctx, after_valid, (int)sizeof(after_valid), 1000 + i * 33);
+	cea_flush(ctx);
+
+	const unsigned char *cc_data;
+	int cc_count = -1;
+	if (cea_extract_cc_data(ctx, after_valid, (int)sizeof(after_valid), &cc_data, &cc_count) != 0 || cc_count != 0)
+	{
+		fprintf(stderr, "FAIL: hostile NAL length: got %d triplet(s)\n", cc_count);
+		failures++;
+	}
+	cc_count = -1;
+	if (cea_extract_cc_data(ctx, truncated, (int)sizeof(truncated), &cc_data, &cc_count) != 0 || cc_count != 0)
+	{
+		fprintf(stderr, "FAIL: truncated NAL: got %d triplet(s)\n", cc_count);
+		failures++;
+	}
+	cea_free(ctx);
+
+	ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return failures + 1;
+	}
+	cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_AVCC, NULL, 0);
+	cea_feed_packet(ctx, first, (int)sizeof(first), 1000);
+	cea_flush(ctx);
+	cea_free(ctx);
+
+	if (!failures)
+		printf("PASS: hostile NAL length prefixes dropped\n");
+	return failures;
+}
+
+/* Bit writer for building RBSPs in tests */
+struct bit_writer
+{
+	unsigned char buf[64];
+	int bits;
+};
+
+static void put_bits(struct bit_writer *bw, unsigned int value, int n)
+{
+	while (n-- > 0)
+	{
+		if ((value >> n) & 1)
+			bw->buf[bw->bits / 8] |= (unsigned char)(0x80 >> (bw->bits % 8));
+		bw->bits++;
+	}
+}
+
+static void put_ue(struct bit_writer *bw, unsigned int value)
+{
+	int len = 0;
+	while ((value + 1) >> (len + 1))
+		len++;
+	put_bits(bw, 0, len);
+	put_bits(bw, value + 1, len + 1);
+}
+
+/* Copy an RBSP into a NAL unit, inserting emulation prevention bytes.
+   Returns the size written. */
+static int put_escaped(unsigned char *p, const unsigned char *rbsp, int size)
+{
+	int n = 0, zeros = 0;
+	for (int i = 0; i < size; i++)
+	{
+		if (zeros >= 2 && rbsp[i] <= 3)
+		{
+			p[n++] = 0x03;
+			zeros = 0;
+		}
+		p[n++] = rbsp[i];
+		zeros = rbsp[i] == 0 ? zeros + 1 : 0;
+	}
+	return n;
+}
+
+/* ITU-T T.35 GA94 cc_data with count triplets. Returns its size. */
+static int put_t35(unsigned char *p, const unsigned char *cc, int count)
+{
+	static const unsigned char header[] = { 0xB5, 0x00, 0x31, 0x47, 0x41, 0x39, 0x34, 0x03 };
+	memcpy(p, header, sizeof(header));
+	p[8] = (unsigned char)(0x40 | count); /* process_cc_data_flag */
+	p[9] = 0xFF;                          /* em_data */
+	memcpy(p + 10, cc, count * 3);
+	p[10 + count * 3] = 0xFF; /* marker_bits */
+	return 11 + count * 3;
+}
+
+/* Annex B H.264 SEI NAL with count triplets of cc_data, escaped. Returns
+   its size. */
+static int put_h264_sei(unsigned char *p, const unsigned char *cc, int count)
+{
+	unsigned char rbsp[128];
+	int n = 0;
+	rbsp[n++] = 0x04; /* user_data_registered_itu_t_t35 */
+	n++;              /* payload_size */
+	n += put_t35(rbsp + n, cc, count);
+	rbsp[1] = (unsigned char)(n - 2);
+	rbsp[n++] = 0x80; /* rbsp trailing bits */
+
+	memcpy(p, "\x00\x00\x00\x01\x06", 5);
+	return 5 + put_escaped(p + 5, rbsp, n);
+}
+
+/* Annex B H.264 Main profile SPS signalling max_num_reorder_frames. Its
+   VUI timing info (num_units_in_tick = 1) needs emulation prevention.
+   Returns its size. */
+static int put_h264_sps(unsigned char *p, int max_reorder)
+{
+	struct bit_writer bw = { { 0 }, 0 };
+	put_bits(&bw, 77, 8); /* profile_idc */
+	put_bits(&bw, 0, 8);  /* constraint_set_flags */
+	put_bits(&bw, 30, 8); /* level_idc */
+	put_ue(&bw, 0);       /* seq_parameter_set_id */
+	put_ue(&bw, 0);       /* log2_max_frame_num_minus4 */
+	put_ue(&bw, 0);       /* pic_order_cnt_type */
+	put_ue(&bw, 0);       /* log2_max_pic_order_cnt_lsb_minus4 */
+	put_ue(&bw, 4);       /* max_num_ref_frames */
+	put_bits(&bw, 0, 1);  /* gaps_in_frame_num_value_allowed_flag */
+	put_ue(&bw, 119);     /* pic_width_in_mbs_minus1 */
+	put_ue(&bw, 67);      /* pic_height_in_map_units_minus1 */
+	put_bits(&bw, 1, 1);  /* frame_mbs_only_flag */
+	put_bits(&bw, 1, 1);  /* direct_8x8_inference_flag */
+	put_bits(&bw, 0, 1);  /* frame_cropping_flag */
+	put_bits(&bw, 1, 1);  /* vui_parameters_present_flag */
+	put_bits(&bw, 0, 4);  /* aspect_ratio, overscan, video_signal, chroma_loc */
+	put_bits(&bw, 1, 1);  /* timing_info_present_flag */
+	put_bits(&bw, 1, 32); /* num_units_in_tick */
+	put_bits(&bw, 60, 32); /* time_scale */
+	put_bits(&bw, 1, 1);  /* fixed_frame_rate_flag */
+	put_bits(&bw, 0, 3);  /* nal_hrd, vcl_hrd, pic_struct_present_flag */
+	put_bits(&bw, 1, 1);  /* bitstream_restriction_flag */
+	put_bits(&bw, 1, 1);  /* motion_vectors_over_pic_boundaries_flag */
+	put_ue(&bw, 0);       /* max_bytes_per_pic_denom */
+	put_ue(&bw, 0);       /* max_bits_per_mb_denom */
+	put_ue(&bw, 16);      /* log2_max_mv_length_horizontal */
+	put_ue(&bw, 16);      /* log2_max_mv_length_vertical */
+	put_ue(&bw, max_reorder);
+	put_ue(&bw, 4);       /* max_dec_frame_buffering */
+	put_bits(&bw, 1, 1);  /* rbsp_stop_one_bit */
+
+	memcpy(p, "\x00\x00\x00\x01\x67", 5);
+	return 5 + put_escaped(p + 5, bw.buf, (bw.bits + 7) / 8);
+}
+
+/* Annex B H.264 access unit: an optional SPS, an SEI with one field 1
+   byte pair and an IDR slice. Returns its size. */
+static int put_h264_au(unsigned char *p, int max_reorder, unsigned char b1, unsigned char b2)
+{
+	unsigned char cc[3] = { 0xFC, b1, b2 };
+	int n = 0;
+	if (max_reorder >= 0)
+		n += put_h264_sps(p, max_reorder);
+	n += put_h264_sei(p + n, cc, 1);
+	memcpy(p + n, "\x00\x00\x01\x65\x88\x80", 6);
+	return n + 6;
+}
+
+static void on_count(const cea_caption *cap, void *userdata)
+{
+	(void)cap;
+	(*(int *)userdata)++;
+}
+
+/* Feed an H.264 access unit carrying a 608 byte pair (and an SPS if
+   max_reorder >= 0), then null access units in presentation order until
+   the pair produces a live event. Returns the number of access units that
+   had to follow it: the reorder window in effect. */
+static int probe_h264_window(cea_ctx *ctx, int *events, int *frame, int max_reorder,
+			     unsigned char b1, unsigned char b2)
+{
+	unsigned char pkt[256];
+	int before = *events;
+	int size = put_h264_au(pkt, max_reorder, b1, b2);
+	cea_feed_packet(ctx, pkt, size, 1000 + (*frame)++ * 33);
+
+	int window = 0;
+	while (*events == before && window < 16)
+	{
+		size = put_h264_au(pkt, -1, 0x80, 0x80);
+		cea_feed_packet(ctx, pkt, size, 1000 + (*frame)++ * 33);
+		window++;
+	}
+	return window;
+}
+
+/* Load "Test" into a CC1 pop-on caption, one access unit per pair */
+static void start_h264_caption(cea_ctx *ctx, int *frame, int max_reorder)
+{
+	static const unsigned char pairs[3][2] = { { 0x94, 0x20 }, { 0x54, 0xE5 }, { 0x73, 0xF4 } };
+	unsigned char pkt[256];
+	for (int i = 0; i < 3; i++)
+	{
+		int size = put_h264_au(pkt, i == 0 ? max_reorder : -1, pairs[i][0], pairs[i][1]);
+		cea_feed_packet(ctx, pkt, size, 1000 + (*frame)++ * 33);
+	}
+}
+
+/* SEI and SPS NAL units with emulation prevention bytes must be read as
+   their RBSP: cc_data byte-exact, and the SPS reorder window intact.
+   Returns the number of failures. */
+static int test_h264_epb(void)
+{
+	/* RCL, then pairs that need escaping: 00 00 01 and 00 00 03 */
+	static const unsigned char cc[] = {
+		0xFC, 0x94, 0x20, 0xF8, 0x00, 0x00, 0x01, 0x00, 0x00, 0x03, 0x80, 0x80
+	};
+	unsigned char pkt[256];
+	int failures = 0;
+
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_ANNEX_B, NULL, 0);
+
+	/* Start code and header, SEI message header, T.35 and cc_data, trailing
+	   bits, and two emulation prevention bytes */
+	int size = put_h264_sei(pkt, cc, 4);
+	const unsigned char *cc_data = NULL;
+	int cc_count = -1;
+	if (size != 5 + 2 + 11 + (int)sizeof(cc) + 1 + 2 ||
+	    cea_extract_cc_data(ctx, pkt, size, &cc_data, &cc_count) != 0 ||
+	    cc_count != 4 || memcmp(cc_data, cc, sizeof(cc)) != 0)
+	{
+		fprintf(stderr, "FAIL: escaped SEI: got %d triplet(s)\n", cc_count);
+		failures++;
+	}
+	else
+		printf("PASS: escaped SEI cc_data extracted byte-exact\n");
+	cea_free(ctx);
+
+	/* An escaped SPS signalling a window of 2, unlike the default 4 */
+	size = put_h264_sps(pkt, 2);
+	int escaped = 0;
+	for (int i = 5; i + 2 < size; i++)
+		escaped |= pkt[i] == 0x00 && pkt[i + 1] == 0x00 && pkt[i + 2] == 0x03;
+
+	ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return failures + 1;
+	}
+	cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_ANNEX_B, NULL, 0);
+	int events = 0;
+	cea_set_caption_callback(ctx, on_count, &events);
+	int frame = 0;
+	start_h264_caption(ctx, &frame, 2);
+	int window = probe_h264_window(ctx, &events, &frame, -1, 0x94, 0x2F); /* EOC */
+	cea_free(ctx);
+
+	if (!escaped || window != 2)
+	{
+		fprintf(stderr, "FAIL: escaped SPS: reorder window %d, want 2\n", window);
+		failures++;
+	}
+	else
+		printf("PASS: escaped SPS reorder window read\n");
+	return failures;
+}
+
+/* An SPS that changes mid-stream replaces the reorder window; repeating
+   it changes nothing. Returns the number of failures. */
+static int test_h264_sps_change(void)
+{
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_ANNEX_B, NULL, 0);
+	int events = 0, frame = 0, window[4];
+	cea_set_caption_callback(ctx, on_count, &events);
+
+	start_h264_caption(ctx, &frame, 2);
+	window[0] = probe_h264_window(ctx, &events, &frame, 2, 0x94, 0x2F); /* EOC */
+	window[1] = probe_h264_window(ctx, &events, &frame, 1, 0x94, 0x2C); /* EDM */
+	start_h264_caption(ctx, &frame, 1);
+	window[2] = probe_h264_window(ctx, &events, &frame, 3, 0x94, 0x2F);
+	window[3] = probe_h264_window(ctx, &events, &frame, 3, 0x94, 0x2C);
+	cea_free(ctx);
+
+	if (window[0] != 2 || window[1] != 1 || window[2] != 3 || window[3] != 3)
+	{
+		fprintf(stderr, "FAIL: SPS change: reorder windows %d %d %d %d, want 2 1 3 3\n",
+			window[0], window[1], window[2], window[3]);
+		return 1;
+	}
+	printf("PASS: mid-stream SPS change replaces the reorder window\n");
+	return 0;
+}
+
+/* Annex B HEVC access unit: AUD, prefix SEI with cc, IDR slice header.
+   Returns its size. */
+static int put_hevc_au(unsigned char *p, const unsigned char *cc)
+{
+	static const unsigned char aud[] = { 0x00, 0x00, 0x00, 0x01, 0x46, 0x01, 0x50 };
+	static const unsigned char sei[] = { 0x00, 0x00, 0x01, 0x4E, 0x01, 0x04, 0x0E };
+	static const unsigned char idr[] = { 0x00, 0x00, 0x01, 0x26, 0x01, 0xAF, 0x09, 0x40 };
+	int n = 0;
+
+	memcpy(p + n, aud, sizeof(aud));
+	n += sizeof(aud);
+	memcpy(p + n, sei, sizeof(sei));
+	n += sizeof(sei);
+	n += put_t35(p + n, cc, 1);
+	p[n++] = 0x80; /* rbsp trailing bits */
+	memcpy(p + n, idr, sizeof(idr));
+	n += sizeof(idr);
+	return n;
+}
+
+/* HEVC packets fed in decode order with their DTS must decode like the
+   same cc_data fed in presentation order: B-frames come one frame after
+   the frame they precede. Returns the number of failures. */
+static int test_dts_reorder(void)
+{
+	cea_ctx *packet_ctx = cea_init_default();
+	cea_ctx *feed_ctx = cea_init_default();
+	if (!packet_ctx || !feed_ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		cea_free(packet_ctx);
+		cea_free(feed_ctx);
+		return 1;
+	}
+	cea_set_demuxer(packet_ctx, CEA_CODEC_HEVC, CEA_PACKAGING_ANNEX_B, NULL, 0);
+
+	unsigned char cc[3];
+	unsigned char pkt[64];
+	for (int i = 0; i < 59; i++)
+	{
+		/* Decode order 0, 2, 1, 4, 3, ...: odd frames are B-frames */
+		int n = i == 0 ? 0 : (i % 2 ? i + 1 : i - 1);
+		frame_triplet(n, 1, cc);
+		int size = put_hevc_au(pkt, cc);
+		cea_feed_packet_ex(packet_ctx, pkt, size, 1000 + n * 33, 1000 + (i - 1) * 33, CEA_PACKET_DTS_VALID);
+
+		frame_triplet(i, 1, cc);
+		cea_feed(feed_ctx, cc, 1, 1000 + i * 33);
+	}
+	cea_flush(packet_ctx);
+	cea_flush(feed_ctx);
+
+	cea_caption got[8], want[8];
+	int got_count = cea_get_captions(packet_ctx, got, 8);
+	int want_count = cea_get_captions(feed_ctx, want, 8);
+
+	int failures = 0;
+	if (got_count != 1 || want_count != 1)
+		failures++;
+	for (int i = 0; !failures && i < got_count; i++)
+	{
+		if (!got[i].text || !want[i].text || strcmp(got[i].text, want[i].text) != 0 ||
+		    got[i].start_ms != want[i].start_ms || got[i].end_ms != want[i].end_ms)
+			failures++;
+	}
+	if (failures)
+		fprintf(stderr, "FAIL: DTS reorder: got %d caption(s), want %d\n", got_count, want_count);
+	else
+		printf("PASS: DTS-ordered HEVC packets decoded in presentation order\n");
+
+	cea_free(packet_ctx);
+	cea_free(feed_ctx);
+	return failures;
+}
+
+/* A DTS that stops advancing must not hold captions back forever: past
+   16 buffered packets they are released in PTS order. Returns the number
+   of failures. */
+static int test_dts_stuck(void)
+{
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_ANNEX_B, NULL, 0);
+	int events = 0;
+	cea_set_caption_callback(ctx, on_count, &events);
+
+	unsigned char cc[3];
+	unsigned char pkt[256];
+	int held = -1;
+	for (int n = 0; n < 40 && held < 0; n++)
+	{
+		frame_triplet(n, 1, cc);
+		int size = put_h264_au(pkt, -1, cc[1], cc[2]);
+		cea_feed_packet_ex(ctx, pkt, size, 1000 + n * 33, 0, CEA_PACKET_DTS_VALID);
+		if (events > 0)
+			held = n - 3; /* packets after the EOC */
+	}
+	cea_free(ctx);
+
+	if (held != 16)
+	{
+		fprintf(stderr, "FAIL: stuck DTS: caption held for %d packet(s), want 16\n", held);
+		return 1;
+	}
+	printf("PASS: stuck DTS holds at most 16 packets\n");
+	return 0;
+}
+
+/* Feed H.264 access units with PTS frames 0, 3, 2, 1, 6, 5, 4, ... (a
+   reorder depth of 2) carrying a CC1 "Test" caption from frame 101, so
+   that its pairs arrive out of order. With
+   events set, returns the number of packets fed after the EOC before the
+   live callback fires, -1 if it does not. */
+static int feed_inverted_h264(cea_ctx *ctx, int *events)
+{
+	cea_set_demuxer(ctx, CEA_CODEC_H264, CEA_PACKAGING_ANNEX_B, NULL, 0);
+	if (events)
+		cea_set_caption_callback(ctx, on_count, events);
+
+	unsigned char cc[3];
+	unsigned char pkt[256];
+	int eoc_packet = -1, delay = -1;
+	for (int i = 0; i < 160; i++)
+	{
+		int n = i == 0 ? 0 : i + 2 - 2 * ((i - 1) % 3);
+		frame_triplet(n - 101, 1, cc);
+		int size = put_h264_au(pkt, -1, cc[1], cc[2]);
+		cea_feed_packet(ctx, pkt, size, 1000 + n * 33);
+		if (n == 104)
+			eoc_packet = i;
+		if (events && eoc_packet >= 0 && delay < 0 && *events > 0)
+			delay = i - eoc_packet;
+	}
+	cea_flush(ctx);
+	return delay;
+}
+
+/* adaptive_reorder learns a window of 2 from PTS inverted 2 deep: the
+   caption comes out two packets after its EOC instead of four with the
+   default window, and decodes as in presentation order.
+   Returns the number of failures. */
+static int test_adaptive_reorder(void)
+{
+	cea_options opts = { 0 };
+	opts.adaptive_reorder = 1;
+	cea_ctx *ctx[4] = { cea_init(&opts), cea_init(&opts), cea_init_default(), cea_init_default() };
+	for (int i = 0; i < 4; i++)
+	{
+		if (!ctx[i])
+		{
+			fprintf(stderr, "FAIL: cea_init() returned NULL\n");
+			for (int j = 0; j < 4; j++)
+				cea_free(ctx[j]);
+			return 1;
+		}
+	}
+
+	int adaptive_events = 0, default_events = 0;
+	int adaptive_delay = feed_inverted_h264(ctx[0], &adaptive_events);
+	feed_inverted_h264(ctx[1], NULL);
+	int default_delay = feed_inverted_h264(ctx[2], &default_events);
+
+	/* The same caption in presentation order */
+	unsigned char cc[3];
+	for (int n = 0; n < 160; n++)
+	{
+		frame_triplet(n - 101, 1, cc);
+		cea_feed(ctx[3], cc, 1, 1000 + n * 33);
+	}
+	cea_flush(ctx[3]);
+
+	cea_caption got[4], want[4];
+	int got_count = cea_get_captions(ctx[1], got, 4);
+	int want_count = cea_get_captions(ctx[3], want, 4);
+
+	int failures = 0;
+	if (adaptive_delay != 2 || default_delay != 4 || got_count != 1 || want_count != 1 ||
+	    strcmp(got[0].text, want[0].text) != 0 ||
+	    got[0].start_ms != want[0].start_ms || got[0].end_ms != want[0].end_ms)
+	{
+		fprintf(stderr, "FAIL: adaptive reorder: EOC released after %d packet(s) (default %d), %d caption(s)\n",
+			adaptive_delay, default_delay, got_count);
+		failures++;
+	}
+	else
+		printf("PASS: adaptive reorder window follows the PTS inversion depth\n");
+
+	for (int i = 0; i < 4; i++)
+		cea_free(ctx[i]);
+	return failures;
+}
+
+/* MPEG-2 packet: picture header (I-frame), then GA94 user data before
+   or after the first slice. Returns its size. */
+static int put_mpeg2_picture(unsigned char *p, int user_data_after_slice, const unsigned char *cc)
+{
+	static const unsigned char picture[] = { 0x00, 0x00, 0x01, 0x00, 0x00, 0x0F, 0xFF, 0xF8 };
+	static const unsigned char slice[] = { 0x00, 0x00, 0x01, 0x01, 0x13, 0xF8, 0x7D, 0x29 };
+	static const unsigned char user_data[] = {
+		0x00, 0x00, 0x01, 0xB2, 0x47, 0x41, 0x39, 0x34, 0x03, 0x41, 0xFF
+	};
+	int n = 0;
+
+	memcpy(p + n, picture, sizeof(picture));
+	n += sizeof(picture);
+	if (user_data_after_slice)
+	{
+		memcpy(p + n, slice, sizeof(slice));
+		n += sizeof(slice);
+	}
+	memcpy(p + n, user_data, sizeof(user_data));
+	n += sizeof(user_data);
+	memcpy(p + n, cc, 3);
+	n += 3;
+	p[n++] = 0xFF; /* marker_bits */
+	if (!user_data_after_slice)
+	{
+		memcpy(p + n, slice, sizeof(slice));
+		n += sizeof(slice);
+	}
+	return n;
+}
+
+/* MPEG-2 user data is read up to the first slice; user data after it is
+   only found with full_packet_scan. Returns the number of failures. */
+static int test_mpeg2_stop_at_slice(void)
+{
+	static const struct
+	{
+		int after_slice;
+		int full_packet_scan;
+		int want_count;
+	} cases[] = {
+		{ 0, 0, 1 },
+		{ 1, 0, 0 },
+		{ 1, 1, 1 },
+	};
+	unsigned char cc[3];
+	unsigned char pkt[64];
+	int failures = 0;
+
+	frame_triplet(0, 1, cc);
+	for (int c = 0; c < 3; c++)
+	{
+		cea_options opts = { 0 };
+		opts.full_packet_scan = cases[c].full_packet_scan;
+		cea_ctx *ctx = cea_init(&opts);
+		if (!ctx)
+		{
+			fprintf(stderr, "FAIL: cea_init() returned NULL\n");
+			return failures + 1;
+		}
+		cea_set_demuxer(ctx, CEA_CODEC_MPEG2, CEA_PACKAGING_ANNEX_B, NULL, 0);
+
+		int size = put_mpeg2_picture(pkt, cases[c].after_slice, cc);
+		const unsigned char *cc_data = NULL;
+		int cc_count = -1;
+		if (cea_extract_cc_data(ctx, pkt, size, &cc_data, &cc_count) != 0 ||
+		    cc_count != cases[c].want_count || (cc_count && memcmp(cc_data, cc, 3) != 0))
+		{
+			fprintf(stderr, "FAIL: MPEG-2 user data %s the slice, full_packet_scan=%d: got %d triplet(s)\n",
+				cases[c].after_slice ? "after" : "before", cases[c].full_packet_scan, cc_count);
+			failures++;
+		}
+		cea_free(ctx);
+	}
+	if (!failures)
+		printf("PASS: MPEG-2 user data after the first slice needs full_packet_scan\n");
+	return failures;
+}
+
+/* Rewrite an Annex B packet with 4-byte NAL length prefixes (AVCC/hvcC).
+   Returns the new size. */
+static int put_length_prefixed(unsigned char *p, const unsigned char *annexb, int size)
+{
+	int n = 0;
+	int pos = 0;
+	while (pos < size)
+	{
+		int start = pos + (annexb[pos + 2] == 0x01 ? 3 : 4);
+		int end = start;
+		while (end + 2 < size && !(annexb[end] == 0x00 && annexb[end + 1] == 0x00 && annexb[end + 2] == 0x01))
+			end++;
+		if (end + 2 >= size)
+			end = size;
+		else if (annexb[end - 1] == 0x00)
+			end--; /* zero_byte of a 4-byte start code */
+		p[n++] = 0x00;
+		p[n++] = 0x00;
+		p[n++] = (unsigned char)((end - start) >> 8);
+		p[n++] = (unsigned char)(end - start);
+		memcpy(p + n, annexb + start, end - start);
+		n += end - start;
+		pos = end;
+	}
+	return n;
+}
+
+/* cea_extract_cc_data on an HEVC access unit with a prefix SEI, in Annex B
+   and in hvcC (4-byte length prefixed) packaging. Returns the number of
+   failures. */
+static int test_hevc_extract(void)
+{
+	unsigned char cc[3];
+	unsigned char annexb[64], hvcc[64];
+	int failures = 0;
+
+	frame_triplet(0, 1, cc);
+	int annexb_size = put_hevc_au(annexb, cc);
+
+	int hvcc_size = put_length_prefixed(hvcc, annexb, annexb_size);
+
+	for (int packaging = 0; packaging < 2; packaging++)
+	{
+		cea_ctx *ctx = cea_init_default();
+		if (!ctx)
+		{
+			fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+			return failures + 1;
+		}
+		cea_set_demuxer(ctx, CEA_CODEC_HEVC, packaging ? CEA_PACKAGING_AVCC : CEA_PACKAGING_ANNEX_B, NULL, 0);
+
+		const unsigned char *cc_data = NULL;
+		int cc_count = -1;
+		if (cea_extract_cc_data(ctx, packaging ? hvcc : annexb, packaging ? hvcc_size : annexb_size,
+					&cc_data, &cc_count) != 0 ||
+		    cc_count != 1 || memcmp(cc_data, cc, 3) != 0)
+		{
+			fprintf(stderr, "FAIL: HEVC prefix SEI (%s): got %d triplet(s)\n",
+				packaging ? "hvcC" : "Annex B", cc_count);
+			failures++;
+		}
+		cea_free(ctx);
+	}
+	if (!failures)
+		printf("PASS: extracted cc_data from HEVC prefix SEI (Annex B and hvcC)\n");
+	return failures;
+}
+
+/* cea_extract_cc_data on an AV1 temporal unit: a temporal delimiter, a
+   frame OBU with a two-byte size, then an ITU-T T.35 metadata OBU with an
+   extension header. Returns the number of failures. */
+static int test_av1_extract(void)
+{
+	unsigned char cc[6];
+	unsigned char pkt[256];
+	int n = 0;
+
+	frame_triplet(0, 1, cc);
+	frame_triplet(1, 1, cc + 3);
+	memcpy(pkt + n, "\x12\x00", 2); /* temporal delimiter */
+	n += 2;
+	memcpy(pkt + n, "\x32\x82\x01", 3); /* frame OBU, 130 bytes */
+	n += 3;
+	memset(pkt + n, 0x2A, 130); /* looks like metadata OBU headers */
+	n += 130;
+	memcpy(pkt + n, "\x2E\x00\x11\x04", 4); /* metadata OBU, extension, 17 bytes, T.35 */
+	n += 4;
+	n += put_t35(pkt + n, cc, 2) - 1; /* no marker_bits in AV1 */
+
+	cea_ctx *ctx = cea_init_default();
+	if (!ctx)
+	{
+		fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+		return 1;
+	}
+	cea_set_demuxer(ctx, CEA_CODEC_AV1, CEA_PACKAGING_ANNEX_B, NULL, 0);
+
+	const unsigned char *cc_data = NULL;
+	int cc_count = -1;
+	int failures = 0;
+	if (cea_extract_cc_data(ctx, pkt, n, &cc_data, &cc_count) != 0 ||
+	    cc_count != 2 || memcmp(cc_data, cc, sizeof(cc)) != 0)
+	{
+		fprintf(stderr, "FAIL: AV1 T.35 metadata OBU: got %d triplet(s)\n", cc_count);
+		failures++;
+	}
+	else
+		printf("PASS: extracted cc_data from AV1 T.35 metadata OBU\n");
+	cea_free(ctx);
+	return failures;
+}
+
+/* cea_extract_cc_data returns the cc_data of each H.264 packet, Annex B
+   or AVCC, without decoding it. Returns the number of failures. */
+static int test_h264_extract(void)
+{
+	unsigned char cc[3];
+	unsigned char annexb[256], avcc[256];
+	int failures = 0;
+
+	for (int packaging = 0; packaging < 2; packaging++)
+	{
+		cea_ctx *ctx = cea_init_default();
+		if (!ctx)
+		{
+			fprintf(stderr, "FAIL: cea_init_default() returned NULL\n");
+			return failures + 1;
+		}
+		cea_set_demuxer(ctx, CEA_CODEC_H264, packaging ? CEA_PACKAGING_AVCC : CEA_PACKAGING_ANNEX_B, NULL, 0);
+
+		int bad_packets = 0;
+		for (int n = 0; n < 60; n++)
+		{
+			frame_triplet(n, 1, cc);
+			int size = put_h264_au(annexb, n == 0 ? 2 : -1, cc[1], cc[2]);
+			if (packaging)
+				size = put_length_prefixed(avcc, annexb, size);
+
+			const unsigned char *cc_data = NULL;
+			int cc_count = -1;
+			if (cea_extract_cc_data(ctx, packaging ? avcc : annexb, size, &cc_data, &cc_count) != 0 ||
+			    cc_count != 1 || memcmp(cc_data, cc, 3) != 0)
+				bad_packets++;
+		}
+		cea_flush(ctx);
+
+		cea_caption captions[4];
+		int count = cea_get_captions(ctx, captions, 4);
+		if (bad_packets || count != 0)
+		{
+			fprintf(stderr, "FAIL: H.264 SEI (%s): %d bad packet(s), %d caption(s) decoded\n",
+				packaging ? "AVCC" : "Annex B", bad_packets, count);
+			failures++;
+		}
+		cea_free(ctx);
+	}
+	if (!failures)
+		printf("PASS: extracted cc_data from H.264 SEI (Annex B and AVCC) without decoding\n");
+	return failures;
+}
+
 int main(void)
 {
+	int failures = 0;
+
 	printf("=== libcea smoke test ===\n\n");
 
 	/* ---- Live callback mode (pts_ms) ---- */
@@ -113,6 +1504,39 @@ int main(void)
 
 	cea_free(pull_ctx);
 
+	/* ---- Demuxer robustness ---- */
+	/* ---- EIA-608 timing ---- */
+	printf("\n--- 608 ---\n");
+	failures += test_608_pending_at_zero();
+	failures += test_608_golden();
+	failures += test_cc2_only();
+
+	/* ---- CEA-708 live events ---- */
+	printf("\n--- 708 ---\n");
+	failures += test_708_live();
+	failures += test_708_split_golden();
+	failures += test_708_services_golden();
+
+	/* ---- cc_data triplet types ---- */
+	printf("\n--- cc_data ---\n");
+	failures += test_cc_data_golden();
+
+	/* ---- Caption getters ---- */
+	printf("\n--- getters ---\n");
+	failures += test_caption_order();
+
+	printf("\n--- demuxer ---\n");
+	failures += test_hostile_nal_length();
+	failures += test_h264_epb();
+	failures += test_h264_sps_change();
+	failures += test_dts_reorder();
+	failures += test_dts_stuck();
+	failures += test_adaptive_reorder();
+	failures += test_mpeg2_stop_at_slice();
+	failures += test_hevc_extract();
+	failures += test_av1_extract();
+	failures += test_h264_extract();
+
 	printf("\n=== Done ===\n");
-	return 0;
+	return failures ? 1 : 0;
 }